@@ -2,6 +2,14 @@
 #define BASIC_H
 
 #include "whisper64.h"
+#include "basic_tokens.h"
+
+// BASIC V2 keyword lookup, from tables generated at build time.
+// basic_token: token of exactly the len characters at s, or 0.
+// basic_match: token of the longest keyword s starts with, or 0, and
+// its length in *len - what the C64's own tokenizer would read there.
+uint8_t basic_token(const char *s, uint8_t len);
+uint8_t basic_match(const char *s, uint8_t *len);
 
 // BASIC operations
 int extract_line_number(const char *line);
@@ -0,0 +1,15 @@
+#ifndef BLOCKIO_H
+#define BLOCKIO_H
+
+#include "whisper64.h"
+#include "editor_state.h"
+
+// Merge a file into the document at the cursor. The file is streamed
+// straight into the page store; pages are split and added as needed.
+void insert_file(const DirEntry *entry);
+
+// Write the marked region, which may span pages, to a SEQ file.
+// One page at a time goes through lines[].
+void write_block(void);
+
+#endif // BLOCKIO_H
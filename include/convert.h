@@ -0,0 +1,53 @@
+#ifndef CONVERT_H
+#define CONVERT_H
+
+#include "whisper64.h"
+
+// Character set of a file on disk
+#define CONV_CHARSET_RAW     0   // no translation (temp pages)
+#define CONV_CHARSET_ASCII   1   // PC text, UTF-8 decoded on load
+#define CONV_CHARSET_PETSCII 2   // C64 text, lower/upper charset
+
+// Line ending convention of a file on disk
+#define CONV_EOL_CR   0
+#define CONV_EOL_LF   1
+#define CONV_EOL_CRLF 2
+
+// Tab stops used when expanding tabs on load (power of two)
+#define TAB_WIDTH 4
+
+typedef struct {
+    unsigned char charset;
+    unsigned char eol;
+} FileFormat;
+
+// Convention of the loaded document - written back on save
+extern FileFormat file_format;
+
+// Format used for temp page files and new documents
+extern const FileFormat raw_format;
+extern const FileFormat default_format;
+
+// Guess charset and line endings from the first block of a file
+void conv_detect(const unsigned char *buf, int len, FileFormat *fmt);
+
+// Content sniff: NUL bytes or many control codes mean binary.
+// prg_like lowers the threshold for PRG/USR directory entries.
+unsigned char conv_is_binary(const unsigned char *buf, int len,
+                             unsigned char prg_like);
+
+// Input: build the byte class table for a format, then feed bytes.
+// conv_feed() appends to line at *pos and returns 1 when the line ended
+// (line is NUL-terminated at that point).
+void conv_begin_input(const FileFormat *fmt);
+unsigned char conv_feed(unsigned char ch, char *line, int *pos);
+
+// Output: select translation, then write lines to the current channel
+void conv_begin_output(const FileFormat *fmt);
+void conv_write_line(const char *line);
+void conv_write_eol(void);
+
+// Short tag for status messages ("PET", "CRLF", ...)
+const char *conv_format_name(const FileFormat *fmt);
+
+#endif // CONVERT_H
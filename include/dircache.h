@@ -0,0 +1,55 @@
+#ifndef DIRCACHE_H
+#define DIRCACHE_H
+
+#include "whisper64.h"
+#include "editor_state.h"
+#include <stdint.h>
+
+// Compact directory entry as stored in the cache
+typedef struct {
+    char name[16];        // padded with zeros, not terminated at 16 chars
+    uint16_t blocks;
+    uint8_t type;         // CBM type byte 0x80-0x84, bit 6 = locked
+} DirRecord;
+
+// Records for all cached listings: 64 in RAM, or about 860 in the REU.
+// A listing that needs the whole store drops the others.
+#define DIR_RAM_ENTRIES 64
+#define DIR_REU_BYTES 16384
+
+void dir_cache_init(void);
+
+// Make drive's listing current. Returns 1 if it is cached and valid;
+// num_dir_entries, disk_name, disk_id, blocks_free and dir_pattern
+// are restored.
+unsigned char dir_select(int drive);
+
+// Build a new listing for drive: dir_begin, dir_add per entry, dir_end.
+// dir_add returns 0 once the listing fills the whole store.
+void dir_begin(int drive, const char *pattern);
+unsigned char dir_add(const DirRecord *rec);
+void dir_end(void);
+
+void dir_get(int index, DirEntry *out);
+unsigned char dir_truncated(void);
+
+// Sorted, filtered view of the current listing, as an index array.
+// dir_view rebuilds it from the whole listing; dir_narrow only drops
+// entries from the current view, for when the filter got longer.
+#define SORT_DISK 0
+#define SORT_NAME 1
+#define SORT_SIZE 2
+#define SORT_TYPE 3
+
+void dir_view(const char *filter, unsigned char sort);
+void dir_narrow(const char *filter);
+int dir_view_count(void);
+void dir_view_get(int pos, DirEntry *out);
+const char *dir_sort_name(unsigned char sort);
+
+// Forget the cached listing after anything is written to drive
+void dir_invalidate(int drive);
+
+extern char dir_pattern[17];
+
+#endif // DIRCACHE_H
@@ -0,0 +1,22 @@
+#ifndef DOCS_H
+#define DOCS_H
+
+#include "whisper64.h"
+
+// Several open documents, each with its own window of REU pages.
+// The document in front lives in the usual editor globals; the others
+// are parked in REU with their cursor, format and undo history.
+#define DOC_MAX_SLOTS 4
+
+// Must run after every other reu_reserve caller: it splits what is
+// left of the page store between the slots
+void docs_init(void);
+
+// Bring slot to the front. Costs one page DMA each way.
+void doc_switch(int slot);
+void doc_next(void);
+
+extern int doc_slot;
+extern int doc_slots;
+
+#endif // DOCS_H
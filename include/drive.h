@@ -0,0 +1,50 @@
+#ifndef DRIVE_H
+#define DRIVE_H
+
+#include "whisper64.h"
+
+// Drive sessions: each drive's command channel is opened on first use
+// and kept open, so commands and status reads skip the OPEN/CLOSE.
+// Closing the command channel would close every file on that drive,
+// so a session stays open for as long as the editor runs.
+
+// Parsed error channel reply "NN,MESSAGE,TT,SS"
+typedef struct {
+    unsigned char code;
+    unsigned char track;
+    unsigned char sector;
+    char text[40];          // the reply as sent, without the CR
+} DriveStatus;
+
+// DOS error numbers the editor cares about
+#define DOS_OK              0
+#define DOS_SCRATCHED       1
+#define DOS_WRITE_PROTECT   26
+#define DOS_SYNTAX_ERROR    30
+#define DOS_FILE_NOT_FOUND  62
+#define DOS_FILE_EXISTS     63
+#define DOS_TYPE_MISMATCH   64
+#define DOS_DISK_FULL       72
+#define DOS_NOT_READY       74
+#define DOS_NO_DEVICE       255   // nobody answered on the bus
+
+unsigned char drive_open(int drive);
+
+// Send a DOS command. Returns without waiting for the result; the
+// status is read when someone asks for it.
+unsigned char drive_command(int drive, const char *cmd);
+
+// Scratch files matching pattern ("S0:$W$.*")
+unsigned char drive_scratch(int drive, const char *pattern);
+
+// Something on drive was written or may have changed: drop the cached
+// directory listing and file copies for it
+void drive_changed(int drive);
+
+// Read and parse the error channel
+const DriveStatus *drive_get_status(int drive);
+
+// 00 OK and 01 FILES SCRATCHED both count as success
+#define drive_ok(st) ((st)->code <= DOS_SCRATCHED)
+
+#endif // DRIVE_H
@@ -14,6 +14,12 @@ void new_line(void);
 // Paging
 void save_current_page_to_temp(void);
 void load_page(int page_num);
+int read_page(int page_num);
+void park_page(void);
+void unpark_page(void);
 void check_page_boundary(void);
+void pages_reset(void);
+int page_insert(int at);
+int page_split(int at);
 
 #endif // EDITOR_H
\ No newline at end of file
@@ -21,6 +21,14 @@ extern int current_drive;
 extern char current_filename[17];
 extern char page_modified;
 
+// Logical page -> storage slot (REU page or temp file number), so
+// pages can be inserted without moving their contents
+extern unsigned char page_map[MAX_PAGES];
+extern int page_slots;
+
+// Shared disk block buffer for loaders
+extern unsigned char io_buf[IO_BLOCK_SIZE];
+
 // Search/Replace state
 extern char search_term[21];
 extern char replace_term[21];
@@ -33,10 +41,17 @@ extern int clipboard_lines;
 extern int mark_active;
 extern int mark_start_x, mark_start_y;
 extern int mark_end_x, mark_end_y;
+extern int mark_start_page, mark_end_page;
 
 // BASIC mode
 extern int basic_mode;
 
+// Highlighting language, chosen from the file name; BASIC mode overrides it
+#define LANG_NONE 0
+#define LANG_ASM  1
+#define LANG_C    2
+extern unsigned char syntax_lang;
+
 // Line number mapping for BASIC renumbering
 typedef struct {
     int old_num;
@@ -53,11 +68,9 @@ typedef struct {
     char type[5];
 } DirEntry;
 
-extern DirEntry dir_entries[MAX_DIR_ENTRIES];
 extern int num_dir_entries;
 extern char disk_name[17];
-
-// BASIC keywords
-extern const char *basic_keywords[];
+extern char disk_id[3];
+extern unsigned int blocks_free;
 
 #endif // EDITOR_STATE_H
\ No newline at end of file
@@ -0,0 +1,29 @@
+#ifndef FCACHE_H
+#define FCACHE_H
+
+#include "whisper64.h"
+#include "editor_state.h"
+
+// REU copy of recently loaded files, so reopening one is a DMA instead
+// of a serial bus transfer. Files are keyed by drive, name, block count
+// and disk ID; one 256-byte cache block holds one 254-byte disk block.
+
+// Reserve the cache area (before docs_init splits the page store)
+void fcache_init(void);
+
+// Start reading entry from the cache. Returns 0 if it is not cached.
+unsigned char fcache_open(const DirEntry *entry);
+int fcache_read(unsigned char *buf, unsigned char *eof);
+
+// Record a file while it is loaded from disk: fcache_record makes room
+// (least recently used files go first), fcache_write stores each block
+// as read, and fcache_commit publishes it. fcache_abort drops it.
+void fcache_record(const DirEntry *entry);
+void fcache_write(const unsigned char *buf, int len);
+void fcache_commit(void);
+void fcache_abort(void);
+
+// Drop every file cached from drive
+void fcache_invalidate(int drive);
+
+#endif // FCACHE_H
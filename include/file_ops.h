@@ -2,14 +2,19 @@
 #define FILE_OPS_H
 
 #include "whisper64.h"
+#include "editor_state.h"
 
 // File operations
 void save_file(void);
 void new_file(void);
 
+// Block read from an open logical file (sets *eof at end of file)
+int read_block(unsigned char lfn, unsigned char *buf, int max, unsigned char *eof);
+
 // Directory operations
-void load_directory(void);
+void load_directory(const char *pattern);
 void show_directory(void);
+void dir_open_name(const DirEntry *entry, char *buf);
 
 // Drive selection
 void select_drive(void);
@@ -0,0 +1,36 @@
+#ifndef FONT_TABLES_H
+#define FONT_TABLES_H
+
+#include <stdint.h>
+
+// 80-column renderer tables, generated at build time from font_4x8.h
+// by tools/gen_font_tables.cmake
+
+// Glyph rows split by nibble: row r of glyph g is font_lr[g * 8 + r] in the
+// high nibble, and FONT_RIGHT bytes further on in the low nibble.
+#define FONT_RIGHT   768
+#define FONT_LR_SIZE (2 * FONT_RIGHT)
+extern const uint8_t font_lr[FONT_LR_SIZE];
+
+// Offset of each character's glyph in font_lr, as low byte and page,
+// by the low 7 bits of the code. Codes below 32 use the space glyph;
+// bit 7 shows the glyph reversed, which the renderer does with an EOR.
+extern const uint8_t glyph_lo[128];
+extern const uint8_t glyph_page[128];
+
+// Start of each screen row in the bitmap and the video matrix
+extern const uint8_t bitmap_row_lo[25], bitmap_row_hi[25];
+extern const uint8_t matrix_row_lo[25], matrix_row_hi[25];
+
+#define BITMAP_ROW(y) ((uint8_t *)(bitmap_row_lo[y] | (bitmap_row_hi[y] << 8)))
+#define MATRIX_ROW(y) ((uint8_t *)(matrix_row_lo[y] | (matrix_row_hi[y] << 8)))
+
+// Row kernel (src/render80.s). Draws the cells for columns r80_col up to
+// r80_end (both even) of the text at r80_src into the bitmap at r80_dst,
+// which points at the first of those cells.
+extern const char *r80_src;
+extern uint8_t *r80_dst;
+extern uint8_t r80_col, r80_end;
+void r80_cells(void);
+
+#endif // FONT_TABLES_H
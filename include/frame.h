@@ -0,0 +1,38 @@
+#ifndef FRAME_H
+#define FRAME_H
+
+#include "whisper64.h"
+#include <stdint.h>
+
+// Frame timing. A raster interrupt at the top of the lower border takes
+// over from the KERNAL's timer interrupt: it counts frames and then runs
+// the KERNAL's handler, so the keyboard is scanned once a frame.
+//
+// The screen is drawn in slices (see screen_slice()): a slice starts on
+// a frame and stops once it has used its budget of cycles, leaving the
+// rest of the damage for the next one so keys are read in between.
+
+#define FRAME_IRQ_LINE 251
+
+// Cycles a slice may draw for. Configure with -DWHISPER64_FRAME_BUDGET.
+#ifndef FRAME_BUDGET
+#define FRAME_BUDGET 12000
+#endif
+
+extern volatile uint8_t frame_count;   // frames since frame_init()
+extern uint8_t frame_pal;              // 1 on PAL machines, 0 on NTSC
+
+// Detect PAL/NTSC and start the raster interrupt
+void frame_init(void);
+
+// Cycles per slice, rounded down to whole raster lines
+void frame_set_budget(uint16_t cycles);
+
+// Wait for the next frame to begin
+void frame_wait(void);
+
+// Start timing a slice; whether it has used up its budget
+void frame_slice_begin(void);
+uint8_t frame_slice_over(void);
+
+#endif // FRAME_H
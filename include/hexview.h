@@ -0,0 +1,12 @@
+#ifndef HEXVIEW_H
+#define HEXVIEW_H
+
+#include "whisper64.h"
+#include "editor_state.h"
+
+// Hex+ASCII view and byte editor for binary files (PRG/USR/...).
+// Data is paged through lines[] and the page store; the open document
+// is parked and restored on exit.
+void hexview_edit(const DirEntry *entry);
+
+#endif // HEXVIEW_H
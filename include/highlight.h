@@ -0,0 +1,43 @@
+#ifndef HIGHLIGHT_H
+#define HIGHLIGHT_H
+
+#include "whisper64.h"
+
+// Syntax coloring. Each line of the current page is lexed into runs of
+// one color class, and the runs are cached per line until that line is
+// edited or the highlighting mode changes, so redraws and scrolls don't
+// lex anything. BASIC mode colors keywords; otherwise the file extension
+// picks an assembler or C lexer (syntax_lang).
+//
+// A run is one byte: class in the top 3 bits, length (1-31) in the low 5.
+// A line's runs end with a 0 byte; columns past the last run are text.
+#define HL_TEXT       0
+#define HL_KEYWORD    1   // BASIC keyword, mnemonic, C keyword
+#define HL_DIRECTIVE  2   // assembler directive, C preprocessor line
+#define HL_LABEL      3
+#define HL_COMMENT    4
+#define HL_STRING     5
+#define HL_NUMBER     6
+
+#define HL_RUN_MAX        31
+#define HL_RUN(cls, len)  (((cls) << 5) | (len))
+#define HL_RUN_CLASS(r)   ((r) >> 5)
+#define HL_RUN_LEN(r)     ((r) & 0x1F)
+
+// Screen color of each class
+extern const unsigned char hl_colors[8];
+
+// Runs of a line of the current page, lexed now if not cached
+const unsigned char *hl_runs(int line);
+
+// Keep the cache in step with lines[]. A line that moves keeps its runs.
+void hl_line_changed(int line);
+void hl_line_inserted(int at);   // lines at and below moved down one
+void hl_line_deleted(int at);    // lines below at moved up one
+void hl_invalidate_all(void);    // page loaded or rewritten wholesale
+
+// After an edit to line: whether the state it hands the next line changed
+// (a /* opened or closed), so the lines below need redrawing too
+int hl_carry_changed(int line);
+
+#endif // HIGHLIGHT_H
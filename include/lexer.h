@@ -0,0 +1,51 @@
+#ifndef LEXER_H
+#define LEXER_H
+
+#include "whisper64.h"
+
+// Table-driven lexers for highlight.c. Each character is looked up in
+// cclass[], then in the language's transition table, and the state it
+// lands in gives its color class. Every state's row only lists its own
+// transitions: a 0 entry means "as from the code state".
+
+// Character classes
+#define CC_OTHER    0
+#define CC_SPACE    1
+#define CC_ALPHA    2   // letters and _
+#define CC_DIGIT    3
+#define CC_DQUOTE   4
+#define CC_SQUOTE   5
+#define CC_SEMI     6
+#define CC_SLASH    7
+#define CC_STAR     8
+#define CC_HASH     9
+#define CC_DOLLAR   10
+#define CC_PERCENT  11
+#define CC_DOT      12
+#define CC_COLON    13
+#define CC_BSLASH   14
+#define CC_BANG     15
+#define CC_COUNT    16
+
+extern const unsigned char cclass[128];
+
+// Color classes only the lexer sees, settled when their run ends: a word
+// becomes a keyword or text, a pending run joins a comment that follows
+// it (the first / of // and /*) or else is text
+#define HL_WORD     8
+#define HL_PENDING  9
+
+typedef struct {
+    const unsigned char (*next)[CC_COUNT];  // [state][class] -> state
+    const unsigned char *cls;               // color class of each state
+    const unsigned char *carry;             // end state -> next line's, 0 = start
+    unsigned char start;                    // state each line starts in
+    unsigned char code;                     // fallback state for 0 entries
+    unsigned char multiline;                // has a carry table
+    int (*is_keyword)(const char *s, unsigned char len);
+} Lexer;
+
+extern const Lexer lexer_asm;
+extern const Lexer lexer_c;
+
+#endif // LEXER_H
@@ -0,0 +1,11 @@
+#ifndef PAGER_H
+#define PAGER_H
+
+#include "whisper64.h"
+#include "editor_state.h"
+
+// Read-only streaming view of a file too large for the page store.
+// Uses lines[] as its window; the open document is restored on exit.
+void pager_view(const DirEntry *entry);
+
+#endif // PAGER_H
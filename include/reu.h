@@ -29,6 +29,16 @@ struct __attribute__((packed)) REU {
 #define REU_CMD_FETCH    0x91   // REU -> C64 (with immediate execute)
 #define REU_CMD_SWAP     0x92   // Swap C64 <-> REU
 
+// Armed commands wait for a write to $FF00, so the transfer can run with
+// I/O (and the REU registers) banked out
+#define REU_CMD_ARM_STASH 0x80
+#define REU_CMD_ARM_FETCH 0x81
+#define REU_TRIGGER()    (*(volatile uint8_t *)0xFF00 = *(volatile uint8_t *)0xFF00)
+
+// Address control register bits
+#define REU_CTRL_FIX_C64    0x80  // C64 address stays put
+#define REU_CTRL_FIX_REU    0x40  // REU address stays put (fill)
+
 // Status register bits
 #define REU_STATUS_IRQ      0x80  // Interrupt pending
 #define REU_STATUS_EOB      0x40  // End of block
@@ -60,12 +70,21 @@ void reu_init(void);
 uint8_t reu_is_available(void);
 uint32_t reu_get_size(void);
 int reu_max_page_count(void);
+REUPtr reu_reserve(uint32_t size);
+void reu_set_page_window(int first, int count);
+int reu_total_page_count(void);
 
 void reu_read(REUPtr reu_addr, void* c64_addr, uint16_t size);
 void reu_write(REUPtr reu_addr, void* c64_addr, uint16_t size);
+void reu_swap(REUPtr reu_addr, void *c64_addr, uint16_t size);
+void reu_arm(uint8_t command, REUPtr reu_addr, void *c64_addr, uint16_t size,
+             uint8_t control);
 
 void reu_save_page(int page_num);
 int reu_load_page(int page_num);
 void reu_clear_pages(void);
 
+void reu_save_raw_page(int page_num, void *buf, uint16_t size);
+void reu_load_raw_page(int page_num, void *buf, uint16_t size);
+
 #endif
\ No newline at end of file
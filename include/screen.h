@@ -13,16 +13,47 @@ void clrscr(void);
 char cgetc(void);
 void cputc_at(int x, int y, char c, unsigned char color);
 void cputs_at(int x, int y, const char *s, unsigned char color);
+void draw_row_text(int y, const char *text, unsigned char color);
+void invert_cell(int x, int y);
+void scroll_rows(int top, int bottom, signed char dir);
 
 // Display functions
 void draw_line_number(int screen_row, int line_num);
 void draw_text_line(int screen_row, int line_num);
-void redraw_screen(void);
 void draw_cursor(void);
-void update_cursor(void);
-void update_current_line(void);  // fast: redraws only current line + cursor
+void update_cursor(void);        // full redraw
+void update_current_line(void);  // fast: redraws only the edited part + cursor
+
+// Damage tracking - mark what changed, then screen_flush() draws just that.
+// Cursor, scroll and page moves are picked up by the flush itself.
+#define DMG_NAME   0x01   // title: file name / document slot
+#define DMG_POS    0x02   // title: line:column
+#define DMG_FLAGS  0x04   // title: mode flags, page and drive
+#define DMG_STATUS 0x08   // blank the status line
+#define DMG_TITLE  (DMG_NAME | DMG_POS | DMG_FLAGS)
+
+void damage_all(void);
+void damage_fields(unsigned char fields);
+void damage_span(int line_num, int from, int to);  // text columns, to exclusive
+void damage_lines(int first, int last);
+void screen_flush(void);
+void screen_switch(void);   // after a 40/80 flip: redraw what the new mode missed
+
+// Deferred drawing for the main loop: screen_schedule() notes that the
+// damage wants drawing, and screen_slice() draws it a frame's budget at
+// a time once no keys are waiting, so a burst of keys costs one redraw
+void screen_schedule(void);
+unsigned char screen_pending(void);
+void screen_slice(void);
 void show_message(const char *msg, unsigned char col);
 
+// Full-screen overlays (help, directory). With an REU the screen is saved
+// on the way in and copied back on the way out, or redrawn without one.
+// Ways out that change the document call update_cursor() instead.
+void screen_snapshot_init(void);   // reserves REU space - before docs_init()
+void screen_modal_begin(void);
+void screen_modal_end(void);
+
 // Helper
 int is_basic_keyword(const char *word);
 
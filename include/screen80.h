@@ -4,8 +4,8 @@
 #include "whisper64.h"
 #include <stdint.h>
 
-// 80-column mode uses VIC-II Bank 3 ($C000-$FFFF)
-// Bitmap at $E000 (8000 bytes), screen/color RAM at $C400
+// 80-column mode uses VIC-II Bank 3 ($C000-$FFFF), in text mode with a
+// character-pair charset at $D000, or as a fallback in bitmap mode
 // Bitmap at $E000 (8KB, under Kernal ROM - VIC sees RAM here)
 #define BITMAP_BASE     ((uint8_t *)0xE000)
 // Video matrix at $D800 - uses the VIC color RAM hardware
@@ -21,7 +21,8 @@
 #define MODE_40COL  0
 #define MODE_80COL  1
 
-// Initialize 80-column subsystem (generate font from ROM)
+// Initialize 80-column subsystem. Reserves the blitter's REU staging
+// area, so it must run before docs_init().
 void screen80_init(void);
 
 // Switch between modes
@@ -32,13 +33,33 @@ void screen80_disable(void);
 void screen80_begin_draw(void);
 void screen80_end_draw(void);
 
-// 80-column rendering primitives
+// 80-column rendering primitives. A character with bit 7 set is drawn
+// reversed, the way the C64's own screen codes work.
 void clrscr_80(void);
 void cputc_at_80(int x, int y, char c, uint8_t color);
 void cputs_at_80(int x, int y, const char *s, uint8_t color);
+void invert_cell_80(int x, int y);
 
-// Fast bulk line renderer - processes entire row at once
+// REU blitter - the CPU does the same work without an REU
+void screen80_fill(uint8_t *dst, uint16_t size, uint8_t value);
+void screen80_move_rows(int top, int bottom, signed char dir);
+
+// Tear-free heavy redraws: drawing between these goes to an REU back
+// buffer that is copied to the screen in the vertical blank
+void screen80_frame_begin(void);
+void screen80_frame_end(void);
+
+// Save the 80-column screen to an REU area of SCREEN80_SNAP_BYTES, and
+// put it back. Call outside a draw block.
+#define SCREEN80_SNAP_BYTES 11280
+void screen80_snapshot(uint32_t area);
+void screen80_restore(uint32_t area);
+
+// Fast bulk line renderer - processes entire row at once. Cells take
+// their colors from cell_colors (one per 2 columns) or, if it is NULL,
+// all use color.
 void render_line_80(int screen_row, const char *text, int text_len,
-                    int start_col, int num_cols, uint8_t color);
+                    int start_col, int num_cols, uint8_t color,
+                    const uint8_t *cell_colors);
 
 #endif
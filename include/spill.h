@@ -0,0 +1,28 @@
+#ifndef SPILL_H
+#define SPILL_H
+
+#include "whisper64.h"
+
+// Write-behind for temp pages when there is no REU. A page leaving
+// lines[] is packed into a RAM buffer and written to its temp file a
+// few bytes at a time from the main loop, between keystrokes. Several
+// pages can wait in the buffer, so quick page turns don't wait on the
+// drive.
+
+// Queue the current page. Waits for the oldest pages to be written only
+// when the buffer is full. Returns 0 if the page is bigger than the
+// whole buffer and must be written the slow way.
+unsigned char spill_queue(int page_num);
+
+// Write the next chunk if no key is waiting
+void spill_pump(void);
+
+// Barrier: finish the pending write before the drive is used for
+// anything that must see it (save, scratch, drive change)
+void spill_flush(void);
+
+// If page_num is still in the buffer, unpack it into lines[] and
+// return its line count; otherwise 0
+int spill_read(int page_num);
+
+#endif // SPILL_H
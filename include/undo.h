@@ -2,6 +2,7 @@
 #define UNDO_H
 
 #include "whisper64.h"
+#include <stdint.h>
 
 // Undo/Redo operations
 void save_undo_state(void);
@@ -10,4 +11,8 @@ void redo_last_action(void);
 int can_undo(void);
 int can_redo(void);
 
+// Raw undo/redo history, so document switching can stash it
+void *undo_history(uint16_t *size);
+void undo_clear(void);
+
 #endif // UNDO_H
\ No newline at end of file
@@ -16,8 +16,8 @@
 // Buffer constants 
 #define MAX_LINE_LENGTH 80
 #define LINES_PER_PAGE 48
-#define MAX_DIR_ENTRIES 40
 #define MAX_LINES 128
+#define MAX_PAGES 160
 
 // Key codes
 #define KEY_RETURN 13
@@ -46,6 +46,8 @@
 #define COL_BLUE 6
 #define COL_PURPLE 4
 #define COL_ORANGE 8
+#define COL_GREY 12
+#define COL_LIGHTBLUE 14
 
 // Macros
 #define POKE(addr,val) (*(unsigned char*)(addr) = (val))
@@ -54,5 +56,10 @@
 
 // Temp file for paging
 #define TEMP_FILE "$W$"
+#define TEMP_LFN 3
+#define SPILL_LFN 4
+
+// Disk read block size (one sector of payload)
+#define IO_BLOCK_SIZE 254
 
 #endif // WHISPER64_H
\ No newline at end of file
@@ -1,6 +1,7 @@
 #include "basic.h"
 #include "editor_state.h"
 #include "screen.h"
+#include "highlight.h"
 
 int extract_line_number(const char *line) {
     int num = 0;
@@ -20,42 +21,102 @@ int extract_line_number(const char *line) {
     return num;
 }
 
+// First trie node for character c, 0 if no keyword starts with it
+static uint8_t trie_root(uint8_t c) {
+    return (c >= 0x20 && c < 0x60) ? basic_trie_root[c - 0x20] : 0;
+}
+
+// Child of node n for character c, 0 if none
+static uint8_t trie_step(uint8_t n, uint8_t c) {
+    for (n = basic_trie_child[n]; n && basic_trie_char[n] != c; n = basic_trie_next[n]) ;
+    return n;
+}
+
+uint8_t basic_token(const char *s, uint8_t len) {
+    uint8_t n, i;
+
+    if (len == 0) return 0;
+    n = trie_root(s[0]);
+    for (i = 1; n && i < len; i++) n = trie_step(n, s[i]);
+    return n ? basic_trie_token[n] : 0;
+}
+
+uint8_t basic_match(const char *s, uint8_t *len) {
+    uint8_t n = trie_root(s[0]), i = 1, tok = 0;
+
+    *len = 0;
+    while (n) {
+        if (basic_trie_token[n]) {
+            tok = basic_trie_token[n];
+            *len = i;
+        }
+        n = trie_step(n, s[i++]);
+    }
+    return tok;
+}
+
+// Line number targets follow GOTO, GOSUB, THEN and GO TO / GO SUB, and
+// ON ... GOTO/GOSUB takes a list of them. The line is read keyword by
+// keyword the way BASIC tokenizes it, so strings and REM are skipped.
 void replace_line_number(char *line, int old_num, int new_num) {
     char temp[MAX_LINE_LENGTH];
-    char *pos;
-    char search[10];
     char replace[10];
-    int line_len, search_len, replace_len;
-    
-    sprintf(search, "%d", old_num);
+    char *pos = line;
+    char *num;
+    int replace_len, num_len, value;
+    uint8_t tok, len;
+
     sprintf(replace, "%d", new_num);
-    search_len = strlen(search);
     replace_len = strlen(replace);
-    
-    const char *keywords[] = {"GOTO ", "GOSUB ", "GO TO ", "GO SUB ", "THEN ", "THEN", "ELSE ", "ELSE", NULL};
-    
-    for (int k = 0; keywords[k] != NULL; k++) {
-        pos = line;
-        while ((pos = strstr(pos, keywords[k])) != NULL) {
-            pos += strlen(keywords[k]);
-            
+
+    while (*pos) {
+        if (*pos == '"') {
+            pos = strchr(pos + 1, '"');
+            if (!pos) return;
+            pos++;
+            continue;
+        }
+
+        tok = basic_match(pos, &len);
+        if (!tok) {
+            pos++;
+            continue;
+        }
+        pos += len;
+        if (tok == TOK_REM) return;
+
+        if (tok == TOK_GO) {
             while (*pos == ' ') pos++;
-            
-            if (strncmp(pos, search, search_len) == 0) {
-                char next_char = pos[search_len];
-                if (next_char == ' ' || next_char == ':' || next_char == '\0' || next_char == ',') {
-                    line_len = strlen(line);
-                    int pos_offset = pos - line;
-                    
-                    if (line_len - search_len + replace_len < MAX_LINE_LENGTH) {
-                        strcpy(temp, pos + search_len);
-                        strcpy(pos, replace);
-                        strcpy(pos + replace_len, temp);
-                        pos += replace_len;
-                        page_modified = 1;
-                    }
-                }
+            if (basic_match(pos, &len) == TOK_TO) {
+                pos += len;
+            } else if (strncmp(pos, "SUB", 3) == 0) {
+                pos += 3;
+            } else {
+                continue;
             }
+        } else if (tok != TOK_GOTO && tok != TOK_GOSUB && tok != TOK_THEN) {
+            continue;
+        }
+
+        // One target, or a comma separated list of them
+        while (1) {
+            while (*pos == ' ') pos++;
+            num = pos;
+            value = 0;
+            while (isdigit(*pos)) value = value * 10 + (*pos++ - '0');
+            num_len = pos - num;
+
+            if (num_len > 0 && value == old_num &&
+                strlen(line) - num_len + replace_len < MAX_LINE_LENGTH) {
+                strcpy(temp, pos);
+                strcpy(num, replace);
+                strcpy(num + replace_len, temp);
+                pos = num + replace_len;
+                page_modified = 1;
+            }
+            while (*pos == ' ') pos++;
+            if (num_len == 0 || *pos != ',') break;
+            pos++;
         }
     }
 }
@@ -113,6 +174,7 @@ void renumber_basic() {
     }
     
     page_modified = 1;
+    hl_invalidate_all();
     update_cursor();
     
     char msg[40];
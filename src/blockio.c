@@ -0,0 +1,210 @@
+#include "blockio.h"
+#include "editor.h"
+#include "screen.h"
+#include "file_ops.h"
+#include "convert.h"
+#include "drive.h"
+#include "highlight.h"
+
+#define BLOCK_LFN 2
+
+void insert_file(const DirEntry *entry) {
+    char name[30];
+    char remainder[MAX_LINE_LENGTH];
+    unsigned char first[IO_BLOCK_SIZE];
+    int line, pos, n, k;
+    int added = 0;
+    unsigned char eof, full = 0;
+    FileFormat fmt;
+
+    dir_open_name(entry, name);
+    cbm_k_setlfs(BLOCK_LFN, current_drive, 2);
+    cbm_k_setnam(name);
+    if (cbm_k_open() != 0) {
+        cbm_k_close(BLOCK_LFN);
+        show_message(drive_get_status(current_drive)->text, COL_RED);
+        return;
+    }
+
+    // Binary files are turned away before the document is touched
+    n = read_block(BLOCK_LFN, io_buf, IO_BLOCK_SIZE, &eof);
+    if (conv_is_binary(io_buf, n, 0)) {
+        cbm_k_close(BLOCK_LFN);
+        show_message("BINARY FILE - NOT INSERTED", COL_RED);
+        return;
+    }
+
+    // Lines below the cursor move to a page of their own, so the file
+    // can be poured into this page and new ones after it. The rest of
+    // the cursor line is appended to the file's last line at the end.
+    // Reading the page back may use io_buf, so the first block waits
+    // in first meanwhile.
+    memcpy(first, io_buf, n);
+    if (!page_split(cursor_y + 1)) {
+        cbm_k_close(BLOCK_LFN);
+        show_message("PAGE STORE FULL", COL_RED);
+        return;
+    }
+    memcpy(io_buf, first, n);
+
+    show_message("INSERTING...", COL_YELLOW);
+    strcpy(remainder, &lines[cursor_y][cursor_x]);
+    lines[cursor_y][cursor_x] = '\0';
+    line = cursor_y;
+    pos = cursor_x;
+    page_modified = 1;
+    mark_active = 0;
+
+    // The inserted file keeps its own charset and line endings
+    conv_detect(io_buf, n, &fmt);
+    conv_begin_input(&fmt);
+
+    while (n > 0 && !full) {
+        for (k = 0; k < n; k++) {
+            if (!conv_feed(io_buf[k], lines[line], &pos)) continue;
+
+            line++;
+            added++;
+            pos = 0;
+
+            if (line >= LINES_PER_PAGE) {
+                num_lines = line;
+                if (!page_insert(current_page + 1)) {
+                    full = 1;
+                    line--;
+                    added--;
+                    pos = strlen(lines[line]);
+                    break;
+                }
+                save_current_page_to_temp();
+                current_page++;
+                memset(lines, 0, sizeof(lines));
+                line = 0;
+                page_modified = 1;
+            }
+        }
+        if (eof) break;
+        n = read_block(BLOCK_LFN, io_buf, IO_BLOCK_SIZE, &eof);
+    }
+    cbm_k_close(BLOCK_LFN);
+
+    // Last line of the file joins what followed the cursor
+    lines[line][pos] = '\0';
+    cursor_y = line;
+    cursor_x = pos;
+    strncat(lines[line], remainder, MAX_LINE_LENGTH - 1 - pos);
+    num_lines = line + 1;
+    total_lines += added;
+    page_modified = 1;
+    hl_invalidate_all();
+
+    scroll_offset = cursor_y - EDIT_HEIGHT + 1;
+    if (scroll_offset < 0) scroll_offset = 0;
+    update_cursor();
+
+    if (full) {
+        show_message("PAGE STORE FULL - INSERT CUT SHORT", COL_RED);
+    } else {
+        char msg[40];
+        sprintf(msg, "INSERTED %d LINES", added + 1);
+        show_message(msg, COL_GREEN);
+    }
+}
+
+static int prompt_name(const char *prompt, char *name) {
+    int i = 0, x = strlen(prompt);
+
+    show_message(prompt, COL_YELLOW);
+    while (1) {
+        char c = cgetc();
+        if (c == KEY_RETURN) break;
+        if (c == KEY_STOP) return 0;
+        if (c == KEY_DELETE && i > 0) {
+            i--;
+            cputc_at(x + i, 24, ' ', COL_YELLOW);
+        } else if (c >= 32 && c < 128 && i < 16) {
+            name[i] = c;
+            cputc_at(x + i, 24, c, COL_YELLOW);
+            i++;
+        }
+    }
+    name[i] = '\0';
+    return i;
+}
+
+// Mark ends as (page, line, column), in document order
+static int pos_before(int pa, int ya, int xa, int pb, int yb, int xb) {
+    if (pa != pb) return pa < pb;
+    if (ya != yb) return ya < yb;
+    return xa < xb;
+}
+
+void write_block(void) {
+    char name[17];
+    char full_name[30];
+    char seg[MAX_LINE_LENGTH];
+    int sp, sy, sx, ep, ey, ex;
+    int p, y, n, from, to, first = 1;
+    const DriveStatus *st;
+
+    if (!mark_active) {
+        show_message("NO MARK - PRESS CTRL+K", COL_RED);
+        return;
+    }
+
+    if (pos_before(mark_end_page, mark_end_y, mark_end_x,
+                   mark_start_page, mark_start_y, mark_start_x)) {
+        sp = mark_end_page; sy = mark_end_y; sx = mark_end_x;
+        ep = mark_start_page; ey = mark_start_y; ex = mark_start_x;
+    } else {
+        sp = mark_start_page; sy = mark_start_y; sx = mark_start_x;
+        ep = mark_end_page; ey = mark_end_y; ex = mark_end_x;
+    }
+
+    if (!prompt_name("WRITE BLOCK TO: ", name)) {
+        show_message("CANCELLED", COL_RED);
+        return;
+    }
+
+    sprintf(full_name, "@0:%s,S,W", name);
+    drive_changed(current_drive);
+    cbm_k_setlfs(BLOCK_LFN, current_drive, 2);
+    cbm_k_setnam(full_name);
+    if (cbm_k_open() != 0) {
+        cbm_k_close(BLOCK_LFN);
+        show_message("WRITE ERROR - OPEN FAIL", COL_RED);
+        return;
+    }
+    show_message("WRITING...", COL_YELLOW);
+
+    // Borrow lines[] to walk the pages of the region
+    park_page();
+    conv_begin_output(&file_format);
+
+    for (p = sp; p <= ep; p++) {
+        n = read_page(p);
+        cbm_k_chkout(BLOCK_LFN);
+
+        for (y = (p == sp) ? sy : 0; y < n && (p < ep || y <= ey); y++) {
+            from = (p == sp && y == sy) ? sx : 0;
+            to = (p == ep && y == ey) ? ex : (int)strlen(lines[y]);
+            if (from > to) from = to;
+
+            if (!first) conv_write_eol();
+            first = 0;
+
+            memcpy(seg, lines[y] + from, to - from);
+            seg[to - from] = '\0';
+            conv_write_line(seg);
+        }
+        cbm_k_clrch();
+    }
+
+    cbm_k_close(BLOCK_LFN);
+    unpark_page();
+    update_cursor();
+
+    st = drive_get_status(current_drive);
+    show_message(drive_ok(st) ? "BLOCK WRITTEN" : st->text,
+                 drive_ok(st) ? COL_GREEN : COL_RED);
+}
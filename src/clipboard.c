@@ -10,11 +10,19 @@ void mark_toggle() {
         mark_start_y = cursor_y;
         mark_end_x = cursor_x;
         mark_end_y = cursor_y;
+        mark_start_page = current_page;
+        mark_end_page = current_page;
+        damage_fields(DMG_FLAGS);
+        screen_flush();
         show_message("MARK ON - ARROWS, CTRL+C=COPY", COL_GREEN);
     } else {
+        // Only the marked lines and the [M] flag change
+        damage_lines(mark_start_y < mark_end_y ? mark_start_y : mark_end_y,
+                     mark_start_y < mark_end_y ? mark_end_y : mark_start_y);
+        damage_fields(DMG_FLAGS);
         mark_active = 0;
+        screen_flush();
         show_message("MARK OFF", COL_RED);
-        update_cursor();
     }
 }
 
@@ -0,0 +1,286 @@
+#include "convert.h"
+#include <stdint.h>
+
+FileFormat file_format = { CONV_CHARSET_ASCII, CONV_EOL_CR };
+const FileFormat raw_format = { CONV_CHARSET_RAW, CONV_EOL_CR };
+const FileFormat default_format = { CONV_CHARSET_ASCII, CONV_EOL_CR };
+
+// Byte classes for the input state machine. CC_CHAR is the fast path:
+// one class lookup plus one translation lookup per byte.
+#define CC_CHAR   0
+#define CC_EOL    1
+#define CC_DROP   2
+#define CC_TAB    3
+#define CC_BAD    4   // invalid UTF-8 byte
+#define CC_CONT   5   // UTF-8 continuation byte
+#define CC_LEAD2  6
+#define CC_LEAD3  7
+#define CC_LEAD4  8
+
+// Identity mapping - ASCII files and raw temp pages
+static const unsigned char conv_identity[256] = {
+    /* 00 */ 0x00,0x01,0x02,0x03,0x04,0x05,0x06,0x07,0x08,0x09,0x0A,0x0B,0x0C,0x0D,0x0E,0x0F,
+    /* 10 */ 0x10,0x11,0x12,0x13,0x14,0x15,0x16,0x17,0x18,0x19,0x1A,0x1B,0x1C,0x1D,0x1E,0x1F,
+    /* 20 */ 0x20,0x21,0x22,0x23,0x24,0x25,0x26,0x27,0x28,0x29,0x2A,0x2B,0x2C,0x2D,0x2E,0x2F,
+    /* 30 */ 0x30,0x31,0x32,0x33,0x34,0x35,0x36,0x37,0x38,0x39,0x3A,0x3B,0x3C,0x3D,0x3E,0x3F,
+    /* 40 */ 0x40,0x41,0x42,0x43,0x44,0x45,0x46,0x47,0x48,0x49,0x4A,0x4B,0x4C,0x4D,0x4E,0x4F,
+    /* 50 */ 0x50,0x51,0x52,0x53,0x54,0x55,0x56,0x57,0x58,0x59,0x5A,0x5B,0x5C,0x5D,0x5E,0x5F,
+    /* 60 */ 0x60,0x61,0x62,0x63,0x64,0x65,0x66,0x67,0x68,0x69,0x6A,0x6B,0x6C,0x6D,0x6E,0x6F,
+    /* 70 */ 0x70,0x71,0x72,0x73,0x74,0x75,0x76,0x77,0x78,0x79,0x7A,0x7B,0x7C,0x7D,0x7E,0x7F,
+    /* 80 */ 0x80,0x81,0x82,0x83,0x84,0x85,0x86,0x87,0x88,0x89,0x8A,0x8B,0x8C,0x8D,0x8E,0x8F,
+    /* 90 */ 0x90,0x91,0x92,0x93,0x94,0x95,0x96,0x97,0x98,0x99,0x9A,0x9B,0x9C,0x9D,0x9E,0x9F,
+    /* A0 */ 0xA0,0xA1,0xA2,0xA3,0xA4,0xA5,0xA6,0xA7,0xA8,0xA9,0xAA,0xAB,0xAC,0xAD,0xAE,0xAF,
+    /* B0 */ 0xB0,0xB1,0xB2,0xB3,0xB4,0xB5,0xB6,0xB7,0xB8,0xB9,0xBA,0xBB,0xBC,0xBD,0xBE,0xBF,
+    /* C0 */ 0xC0,0xC1,0xC2,0xC3,0xC4,0xC5,0xC6,0xC7,0xC8,0xC9,0xCA,0xCB,0xCC,0xCD,0xCE,0xCF,
+    /* D0 */ 0xD0,0xD1,0xD2,0xD3,0xD4,0xD5,0xD6,0xD7,0xD8,0xD9,0xDA,0xDB,0xDC,0xDD,0xDE,0xDF,
+    /* E0 */ 0xE0,0xE1,0xE2,0xE3,0xE4,0xE5,0xE6,0xE7,0xE8,0xE9,0xEA,0xEB,0xEC,0xED,0xEE,0xEF,
+    /* F0 */ 0xF0,0xF1,0xF2,0xF3,0xF4,0xF5,0xF6,0xF7,0xF8,0xF9,0xFA,0xFB,0xFC,0xFD,0xFE,0xFF,
+};
+
+// PETSCII (lower/upper charset) -> internal ASCII
+static const unsigned char petscii_to_ascii[256] = {
+    /* 00 */ 0x00,0x01,0x02,0x03,0x04,0x05,0x06,0x07,0x08,0x09,0x0A,0x0B,0x0C,0x0D,0x0E,0x0F,
+    /* 10 */ 0x10,0x11,0x12,0x13,0x14,0x15,0x16,0x17,0x18,0x19,0x1A,0x1B,0x1C,0x1D,0x1E,0x1F,
+    /* 20 */ 0x20,0x21,0x22,0x23,0x24,0x25,0x26,0x27,0x28,0x29,0x2A,0x2B,0x2C,0x2D,0x2E,0x2F,
+    /* 30 */ 0x30,0x31,0x32,0x33,0x34,0x35,0x36,0x37,0x38,0x39,0x3A,0x3B,0x3C,0x3D,0x3E,0x3F,
+    /* 40 */ 0x40,0x61,0x62,0x63,0x64,0x65,0x66,0x67,0x68,0x69,0x6A,0x6B,0x6C,0x6D,0x6E,0x6F,
+    /* 50 */ 0x70,0x71,0x72,0x73,0x74,0x75,0x76,0x77,0x78,0x79,0x7A,0x5B,0x5C,0x5D,0x5E,0x5F,
+    /* 60 */ 0xC0,0x41,0x42,0x43,0x44,0x45,0x46,0x47,0x48,0x49,0x4A,0x4B,0x4C,0x4D,0x4E,0x4F,
+    /* 70 */ 0x50,0x51,0x52,0x53,0x54,0x55,0x56,0x57,0x58,0x59,0x5A,0xDB,0xDC,0xDD,0xDE,0xDF,
+    /* 80 */ 0x80,0x81,0x82,0x83,0x84,0x85,0x86,0x87,0x88,0x89,0x8A,0x8B,0x8C,0x8D,0x8E,0x8F,
+    /* 90 */ 0x90,0x91,0x92,0x93,0x94,0x95,0x96,0x97,0x98,0x99,0x9A,0x9B,0x9C,0x9D,0x9E,0x9F,
+    /* A0 */ 0x20,0xA1,0xA2,0xA3,0xA4,0xA5,0xA6,0xA7,0xA8,0xA9,0xAA,0xAB,0xAC,0xAD,0xAE,0xAF,
+    /* B0 */ 0xB0,0xB1,0xB2,0xB3,0xB4,0xB5,0xB6,0xB7,0xB8,0xB9,0xBA,0xBB,0xBC,0xBD,0xBE,0xBF,
+    /* C0 */ 0xC0,0x41,0x42,0x43,0x44,0x45,0x46,0x47,0x48,0x49,0x4A,0x4B,0x4C,0x4D,0x4E,0x4F,
+    /* D0 */ 0x50,0x51,0x52,0x53,0x54,0x55,0x56,0x57,0x58,0x59,0x5A,0xDB,0xDC,0xDD,0xDE,0xDF,
+    /* E0 */ 0x20,0xA1,0xA2,0xA3,0xA4,0xA5,0xA6,0xA7,0xA8,0xA9,0xAA,0xAB,0xAC,0xAD,0xAE,0xAF,
+    /* F0 */ 0xB0,0xB1,0xB2,0xB3,0xB4,0xB5,0xB6,0xB7,0xB8,0xB9,0xBA,0xBB,0xBC,0xBD,0xBE,0xDE,
+};
+
+// Internal ASCII -> PETSCII (lower/upper charset)
+static const unsigned char ascii_to_petscii[256] = {
+    /* 00 */ 0x00,0x01,0x02,0x03,0x04,0x05,0x06,0x07,0x08,0x09,0x0A,0x0B,0x0C,0x0D,0x0E,0x0F,
+    /* 10 */ 0x10,0x11,0x12,0x13,0x14,0x15,0x16,0x17,0x18,0x19,0x1A,0x1B,0x1C,0x1D,0x1E,0x1F,
+    /* 20 */ 0x20,0x21,0x22,0x23,0x24,0x25,0x26,0x27,0x28,0x29,0x2A,0x2B,0x2C,0x2D,0x2E,0x2F,
+    /* 30 */ 0x30,0x31,0x32,0x33,0x34,0x35,0x36,0x37,0x38,0x39,0x3A,0x3B,0x3C,0x3D,0x3E,0x3F,
+    /* 40 */ 0x40,0xC1,0xC2,0xC3,0xC4,0xC5,0xC6,0xC7,0xC8,0xC9,0xCA,0xCB,0xCC,0xCD,0xCE,0xCF,
+    /* 50 */ 0xD0,0xD1,0xD2,0xD3,0xD4,0xD5,0xD6,0xD7,0xD8,0xD9,0xDA,0x5B,0x5C,0x5D,0x5E,0x5F,
+    /* 60 */ 0x60,0x41,0x42,0x43,0x44,0x45,0x46,0x47,0x48,0x49,0x4A,0x4B,0x4C,0x4D,0x4E,0x4F,
+    /* 70 */ 0x50,0x51,0x52,0x53,0x54,0x55,0x56,0x57,0x58,0x59,0x5A,0x7B,0x7C,0x7D,0x7E,0x7F,
+    /* 80 */ 0x80,0x81,0x82,0x83,0x84,0x85,0x86,0x87,0x88,0x89,0x8A,0x8B,0x8C,0x8D,0x8E,0x8F,
+    /* 90 */ 0x90,0x91,0x92,0x93,0x94,0x95,0x96,0x97,0x98,0x99,0x9A,0x9B,0x9C,0x9D,0x9E,0x9F,
+    /* A0 */ 0xA0,0xA1,0xA2,0xA3,0xA4,0xA5,0xA6,0xA7,0xA8,0xA9,0xAA,0xAB,0xAC,0xAD,0xAE,0xAF,
+    /* B0 */ 0xB0,0xB1,0xB2,0xB3,0xB4,0xB5,0xB6,0xB7,0xB8,0xB9,0xBA,0xBB,0xBC,0xBD,0xBE,0xBF,
+    /* C0 */ 0xC0,0xC1,0xC2,0xC3,0xC4,0xC5,0xC6,0xC7,0xC8,0xC9,0xCA,0xCB,0xCC,0xCD,0xCE,0xCF,
+    /* D0 */ 0xD0,0xD1,0xD2,0xD3,0xD4,0xD5,0xD6,0xD7,0xD8,0xD9,0xDA,0xDB,0xDC,0xDD,0xDE,0xDF,
+    /* E0 */ 0xE0,0xE1,0xE2,0xE3,0xE4,0xE5,0xE6,0xE7,0xE8,0xE9,0xEA,0xEB,0xEC,0xED,0xEE,0xEF,
+    /* F0 */ 0xF0,0xF1,0xF2,0xF3,0xF4,0xF5,0xF6,0xF7,0xF8,0xF9,0xFA,0xFB,0xFC,0xFD,0xFE,0xFF,
+};
+
+// Nearest glyph for U+00A0..U+00FF (Latin-1 supplement)
+static const char latin1_fold[96] =
+    " !c#*Y|S\"Ca<--R-o+23'uP.,1o>????"
+    "AAAAAAACEEEEIIIIDNOOOOOxOUUUUYPs"
+    "aaaaaaaceeeeiiiidnooooo/ouuuuypy";
+
+// Per-format class table, rebuilt by conv_begin_input()
+static unsigned char in_class[256];
+static const unsigned char *in_xlat = conv_identity;
+static const unsigned char *out_xlat = conv_identity;
+static unsigned char out_eol = CONV_EOL_CR;
+
+// UTF-8 decoder state
+static unsigned char utf8_need = 0;
+static unsigned char utf8_wide = 0;   // 4-byte sequence - no glyph
+static uint16_t utf8_cp = 0;
+
+void conv_detect(const unsigned char *buf, int len, FileFormat *fmt) {
+    int i;
+    unsigned char c;
+    unsigned char cr = 0, lf = 0, crlf = 0;
+    unsigned char shifted = 0, lower = 0, utf8 = 0;
+
+    for (i = 0; i < len; i++) {
+        c = buf[i];
+        if (c == '\r') {
+            cr = 1;
+            if (i + 1 < len && buf[i + 1] == '\n') crlf = 1;
+        } else if (c == '\n') {
+            lf = 1;
+        } else if (c >= 'a' && c <= 'z') {
+            lower = 1;
+        } else if (c >= 0xC2 && c <= 0xF4 && i + 1 < len &&
+                   (buf[i + 1] & 0xC0) == 0x80) {
+            utf8 = 1;
+        } else if (c >= 0xC1 && c <= 0xDA) {
+            shifted = 1;
+        }
+    }
+
+    if (crlf) {
+        fmt->eol = CONV_EOL_CRLF;
+    } else if (lf && !cr) {
+        fmt->eol = CONV_EOL_LF;
+    } else {
+        fmt->eol = CONV_EOL_CR;
+    }
+
+    // Shifted letters without any ASCII lowercase means C64 mixed-case text.
+    // Plain uppercase CR files are ambiguous - treat as ASCII (unchanged).
+    if (shifted && !lower && !utf8 && !lf) {
+        fmt->charset = CONV_CHARSET_PETSCII;
+    } else {
+        fmt->charset = CONV_CHARSET_ASCII;
+    }
+}
+
+unsigned char conv_is_binary(const unsigned char *buf, int len,
+                             unsigned char prg_like) {
+    int i, ctrl = 0;
+    unsigned char c;
+
+    for (i = 0; i < len; i++) {
+        c = buf[i];
+        if (c == 0) return 1;
+        if (c < 32 && c != '\r' && c != '\n' && c != '\t') ctrl++;
+    }
+
+    // PETSCII text may carry a few color/cursor codes
+    return prg_like ? ctrl * 32 > len : ctrl * 8 > len;
+}
+
+void conv_begin_input(const FileFormat *fmt) {
+    memset(in_class, CC_CHAR, sizeof(in_class));
+    utf8_need = 0;
+
+    if (fmt->charset == CONV_CHARSET_RAW) {
+        in_xlat = conv_identity;
+    } else {
+        memset(in_class, CC_DROP, 32);
+        if (fmt->charset == CONV_CHARSET_PETSCII) {
+            in_xlat = petscii_to_ascii;
+            memset(&in_class[0x80], CC_DROP, 32);
+        } else {
+            in_xlat = conv_identity;
+            in_class['\t'] = CC_TAB;
+            in_class[0x7F] = CC_DROP;
+            memset(&in_class[0x80], CC_CONT, 0x40);
+            memset(&in_class[0xC0], CC_BAD, 0x40);
+            memset(&in_class[0xC2], CC_LEAD2, 0x1E);
+            memset(&in_class[0xE0], CC_LEAD3, 0x10);
+            memset(&in_class[0xF0], CC_LEAD4, 0x05);
+        }
+        in_class['\n'] = CC_DROP;
+    }
+
+    if (fmt->eol == CONV_EOL_LF) {
+        in_class['\r'] = CC_DROP;
+        in_class['\n'] = CC_EOL;
+    } else {
+        in_class['\r'] = CC_EOL;
+    }
+}
+
+// Map a decoded code point to the nearest displayable glyph
+static unsigned char utf8_glyph(uint16_t cp) {
+    if (cp < 0x80) return (unsigned char)cp;
+    if (cp >= 0xA0 && cp <= 0xFF) return latin1_fold[cp - 0xA0];
+    if (cp >= 0x2010 && cp <= 0x2015) return '-';
+    if (cp >= 0x2018 && cp <= 0x201B) return '\'';
+    if (cp >= 0x201C && cp <= 0x201F) return '"';
+    if (cp == 0x2022) return '*';
+    if (cp == 0x2026) return '.';
+    if (cp == 0x2190) return '_';
+    if (cp == 0x2191) return '^';
+    if (cp == 0x2500) return '-';
+    if (cp == 0x2502) return '|';
+    if (cp > 0x2500 && cp < 0x2580) return '+';
+    if (cp >= 0x2580 && cp < 0x25A0) return '#';
+    return '?';
+}
+
+static void put_glyph(unsigned char g, char *line, int *pos) {
+    if (*pos < MAX_LINE_LENGTH - 1) line[(*pos)++] = g;
+}
+
+unsigned char conv_feed(unsigned char ch, char *line, int *pos) {
+    unsigned char cls = in_class[ch];
+
+    if (cls == CC_CHAR && !utf8_need) {
+        if (*pos < MAX_LINE_LENGTH - 1) line[(*pos)++] = in_xlat[ch];
+        return 0;
+    }
+
+    // Truncated UTF-8 sequence - emit a placeholder and resync
+    if (utf8_need && cls != CC_CONT) {
+        utf8_need = 0;
+        put_glyph('?', line, pos);
+    }
+
+    switch (cls) {
+    case CC_CHAR:
+        put_glyph(in_xlat[ch], line, pos);
+        break;
+    case CC_EOL:
+        line[*pos] = '\0';
+        return 1;
+    case CC_TAB:
+        do {
+            put_glyph(' ', line, pos);
+        } while ((*pos & (TAB_WIDTH - 1)) && *pos < MAX_LINE_LENGTH - 1);
+        break;
+    case CC_BAD:
+        put_glyph('?', line, pos);
+        break;
+    case CC_CONT:
+        if (!utf8_need) {
+            put_glyph('?', line, pos);
+            break;
+        }
+        utf8_cp = (utf8_cp << 6) | (ch & 0x3F);
+        if (--utf8_need == 0) {
+            put_glyph(utf8_wide ? '?' : utf8_glyph(utf8_cp), line, pos);
+        }
+        break;
+    case CC_LEAD2:
+        utf8_cp = ch & 0x1F;
+        utf8_need = 1;
+        utf8_wide = 0;
+        break;
+    case CC_LEAD3:
+        utf8_cp = ch & 0x0F;
+        utf8_need = 2;
+        utf8_wide = 0;
+        break;
+    case CC_LEAD4:
+        utf8_cp = 0;
+        utf8_need = 3;
+        utf8_wide = 1;
+        break;
+    }
+    return 0;
+}
+
+void conv_begin_output(const FileFormat *fmt) {
+    out_xlat = (fmt->charset == CONV_CHARSET_PETSCII) ? ascii_to_petscii
+                                                      : conv_identity;
+    out_eol = fmt->eol;
+}
+
+void conv_write_line(const char *line) {
+    while (*line) {
+        cbm_k_chrout(out_xlat[(unsigned char)*line++]);
+    }
+}
+
+void conv_write_eol(void) {
+    if (out_eol != CONV_EOL_LF) cbm_k_chrout('\r');
+    if (out_eol != CONV_EOL_CR) cbm_k_chrout('\n');
+}
+
+const char *conv_format_name(const FileFormat *fmt) {
+    if (fmt->charset == CONV_CHARSET_PETSCII) return "PET";
+    if (fmt->eol == CONV_EOL_CRLF) return "CRLF";
+    if (fmt->eol == CONV_EOL_LF) return "LF";
+    return "CR";
+}
@@ -0,0 +1,280 @@
+#include "dircache.h"
+#include "reu.h"
+#include <string.h>
+
+// Listings are kept per drive (devices 8-15) in one shared store of
+// compact records. A new listing is appended after the last one. When
+// it reaches the end of the store, the other listings are dropped and
+// it moves down to the start, so one listing can always use the whole
+// store.
+#define DIR_DRIVES 8
+
+typedef struct {
+    unsigned char valid;
+    unsigned char truncated;
+    uint16_t first;           // index of the first record in the store
+    uint16_t count;
+    unsigned int blocks_free;
+    char disk_name[17];
+    char disk_id[3];
+    char pattern[17];
+} DirListing;
+
+static DirListing listings[DIR_DRIVES];
+static DirListing *cur = &listings[0];
+
+static DirRecord ram_store[DIR_RAM_ENTRIES];
+static REUPtr reu_store;
+static uint16_t store_size = DIR_RAM_ENTRIES;
+static uint16_t store_used;
+
+char dir_pattern[17];
+
+static const char *const type_names[] = { "DEL", "SEQ", "PRG", "USR", "REL" };
+static const char *const sort_names[] = { "DISK", "NAME", "SIZE", "TYPE" };
+
+#define DIR_MAX_ENTRIES (DIR_REU_BYTES / sizeof(DirRecord))
+
+// The sorted view of the current listing holds one index per record.
+// Without an REU it fits next to the small RAM store; with one it sits
+// in the REU right after the records.
+static uint16_t view[DIR_RAM_ENTRIES];
+static REUPtr reu_view;
+static uint16_t view_count;
+static unsigned char view_sort;
+
+void dir_cache_init(void) {
+    reu_store = reu_reserve(DIR_REU_BYTES + DIR_MAX_ENTRIES * sizeof(uint16_t));
+    if (reu_store) {
+        store_size = DIR_MAX_ENTRIES;
+        reu_view = reu_store + DIR_REU_BYTES;
+    }
+}
+
+static uint16_t view_at(uint16_t pos) {
+    uint16_t index;
+
+    if (!reu_view) return view[pos];
+    reu_read(reu_view + (REUPtr)pos * sizeof(uint16_t), &index, sizeof(index));
+    return index;
+}
+
+static void view_put(uint16_t pos, uint16_t index) {
+    if (reu_view) {
+        reu_write(reu_view + (REUPtr)pos * sizeof(uint16_t), &index, sizeof(index));
+    } else {
+        view[pos] = index;
+    }
+}
+
+unsigned char dir_select(int drive) {
+    cur = &listings[drive & (DIR_DRIVES - 1)];
+    if (!cur->valid) {
+        num_dir_entries = 0;
+        return 0;
+    }
+
+    num_dir_entries = cur->count;
+    blocks_free = cur->blocks_free;
+    strcpy(disk_name, cur->disk_name);
+    strcpy(disk_id, cur->disk_id);
+    strcpy(dir_pattern, cur->pattern);
+    return 1;
+}
+
+static void store_get(uint16_t slot, DirRecord *rec) {
+    if (reu_store) {
+        reu_read(reu_store + (REUPtr)slot * sizeof(DirRecord), rec, sizeof(DirRecord));
+    } else {
+        *rec = ram_store[slot];
+    }
+}
+
+static void store_put(uint16_t slot, const DirRecord *rec) {
+    if (reu_store) {
+        reu_write(reu_store + (REUPtr)slot * sizeof(DirRecord),
+                  (void *)rec, sizeof(DirRecord));
+    } else {
+        ram_store[slot] = *rec;
+    }
+}
+
+// The listing being read ran into the end of the store: drop the others
+// and move what it has so far down to slot 0
+static void store_recycle(void) {
+    DirRecord rec;
+    uint16_t i;
+
+    for (i = 0; i < DIR_DRIVES; i++) {
+        listings[i].valid = 0;
+    }
+    for (i = 0; i < cur->count; i++) {
+        store_get(cur->first + i, &rec);
+        store_put(i, &rec);
+    }
+    cur->first = 0;
+    store_used = 0;
+}
+
+void dir_begin(int drive, const char *pattern) {
+    dir_select(drive);
+
+    // Re-reading the newest listing can reuse its space
+    if (cur->valid && cur->first + cur->count == store_used) {
+        store_used = cur->first;
+    }
+
+    cur->valid = 0;
+    cur->truncated = 0;
+    cur->first = store_used;
+    cur->count = 0;
+    strncpy(cur->pattern, pattern, 16);
+    cur->pattern[16] = '\0';
+    strcpy(dir_pattern, cur->pattern);
+    num_dir_entries = 0;
+}
+
+unsigned char dir_add(const DirRecord *rec) {
+    uint16_t slot = cur->first + cur->count;
+
+    if (slot >= store_size && cur->first > 0) {
+        store_recycle();
+        slot = cur->count;
+    }
+    if (slot >= store_size) {
+        cur->truncated = 1;
+        return 0;
+    }
+
+    store_put(slot, rec);
+    cur->count++;
+    num_dir_entries = cur->count;
+    return 1;
+}
+
+void dir_end(void) {
+    store_used = cur->first + cur->count;
+    cur->blocks_free = blocks_free;
+    strcpy(cur->disk_name, disk_name);
+    strcpy(cur->disk_id, disk_id);
+    cur->valid = 1;
+}
+
+static void fetch(uint16_t index, DirRecord *rec) {
+    store_get(cur->first + index, rec);
+}
+
+void dir_get(int index, DirEntry *out) {
+    DirRecord rec;
+
+    fetch(index, &rec);
+    memcpy(out->name, rec.name, 16);
+    out->name[16] = '\0';
+    out->blocks = rec.blocks;
+    strcpy(out->type, type_names[(rec.type & 0x07) <= 4 ? rec.type & 0x07 : 2]);
+    if (rec.type & 0x40) {
+        strcat(out->type, "*");
+    }
+}
+
+unsigned char dir_truncated(void) {
+    return cur->truncated;
+}
+
+void dir_invalidate(int drive) {
+    listings[drive & (DIR_DRIVES - 1)].valid = 0;
+}
+
+static char fold(char c) {
+    return (c >= 'a' && c <= 'z') ? c - 32 : c;
+}
+
+// Case-insensitive substring match on a 16-char padded name
+static unsigned char name_matches(const DirRecord *rec, const char *filter) {
+    int i, j;
+
+    if (!filter[0]) return 1;
+    for (i = 0; i < 16 && rec->name[i]; i++) {
+        for (j = 0; filter[j] && i + j < 16; j++) {
+            if (fold(rec->name[i + j]) != fold(filter[j])) break;
+        }
+        if (!filter[j]) return 1;
+    }
+    return 0;
+}
+
+static int compare(const DirRecord *a, const DirRecord *b) {
+    if (view_sort == SORT_SIZE && a->blocks != b->blocks) {
+        return a->blocks < b->blocks ? -1 : 1;
+    }
+    if (view_sort == SORT_TYPE && (a->type & 0x07) != (b->type & 0x07)) {
+        return (a->type & 0x07) < (b->type & 0x07) ? -1 : 1;
+    }
+    return memcmp(a->name, b->name, 16);
+}
+
+// Shell sort: no recursion and no extra memory, and each pass touches
+// the records in order, which keeps the REU fetches cheap
+static void sort_view(void) {
+    static const uint16_t gaps[] = { 301, 132, 57, 23, 10, 4, 1 };
+    DirRecord a, b;
+    uint16_t g, i, j, gap, tmp, prev;
+
+    if (view_sort == SORT_DISK) return;
+
+    for (g = 0; g < sizeof(gaps) / sizeof(gaps[0]); g++) {
+        gap = gaps[g];
+        for (i = gap; i < view_count; i++) {
+            tmp = view_at(i);
+            fetch(tmp, &a);
+            for (j = i; j >= gap; j -= gap) {
+                prev = view_at(j - gap);
+                fetch(prev, &b);
+                if (compare(&b, &a) <= 0) break;
+                view_put(j, prev);
+            }
+            view_put(j, tmp);
+        }
+    }
+}
+
+void dir_view(const char *filter, unsigned char sort) {
+    DirRecord rec;
+    uint16_t i;
+
+    view_count = 0;
+    view_sort = sort;
+    for (i = 0; i < cur->count; i++) {
+        fetch(i, &rec);
+        if (name_matches(&rec, filter)) {
+            view_put(view_count++, i);
+        }
+    }
+    sort_view();
+}
+
+void dir_narrow(const char *filter) {
+    DirRecord rec;
+    uint16_t i, index, kept = 0;
+
+    for (i = 0; i < view_count; i++) {
+        index = view_at(i);
+        fetch(index, &rec);
+        if (name_matches(&rec, filter)) {
+            view_put(kept++, index);
+        }
+    }
+    view_count = kept;
+}
+
+int dir_view_count(void) {
+    return view_count;
+}
+
+void dir_view_get(int pos, DirEntry *out) {
+    dir_get(view_at(pos), out);
+}
+
+const char *dir_sort_name(unsigned char sort) {
+    return sort_names[sort];
+}
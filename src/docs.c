@@ -0,0 +1,169 @@
+#include "docs.h"
+#include "editor_state.h"
+#include "screen.h"
+#include "reu.h"
+#include "undo.h"
+#include "convert.h"
+#include "editor.h"
+#include "highlight.h"
+
+// A slot smaller than this is not worth splitting the page store for
+#define DOC_MIN_PAGES 16
+
+// Everything about a document that is not in its pages
+typedef struct {
+    char filename[17];
+    FileFormat format;
+    int num_lines;
+    int total_lines;
+    int current_page;
+    int num_pages;
+    int cursor_x;
+    int cursor_y;
+    int scroll_offset;
+    int basic_mode;
+    unsigned char syntax_lang;
+    char page_modified;
+    int page_slots;
+    unsigned char page_map[MAX_PAGES];
+} DocState;
+
+int doc_slot = 0;
+int doc_slots = 1;
+
+static REUPtr state_area;
+static uint16_t state_stride;
+static unsigned char slot_used[DOC_MAX_SLOTS];
+
+void docs_init(void) {
+    uint16_t undo_size;
+    int per_slot;
+
+    if (!reu_is_available()) return;
+
+    undo_history(&undo_size);
+    state_stride = sizeof(DocState) + undo_size;
+    state_area = reu_reserve((uint32_t)state_stride * DOC_MAX_SLOTS);
+    if (!state_area) return;
+
+    doc_slots = reu_total_page_count() / DOC_MIN_PAGES;
+    if (doc_slots > DOC_MAX_SLOTS) doc_slots = DOC_MAX_SLOTS;
+    if (doc_slots < 2) {
+        doc_slots = 1;
+        return;
+    }
+
+    per_slot = reu_total_page_count() / doc_slots;
+    reu_set_page_window(0, per_slot);
+}
+
+static void doc_stash(void) {
+    DocState st;
+    uint16_t undo_size;
+    void *undo = undo_history(&undo_size);
+    REUPtr addr = state_area + (REUPtr)doc_slot * state_stride;
+
+    strcpy(st.filename, current_filename);
+    st.format = file_format;
+    st.num_lines = num_lines;
+    st.total_lines = total_lines;
+    st.current_page = current_page;
+    st.num_pages = num_pages;
+    st.cursor_x = cursor_x;
+    st.cursor_y = cursor_y;
+    st.scroll_offset = scroll_offset;
+    st.basic_mode = basic_mode;
+    st.syntax_lang = syntax_lang;
+    st.page_modified = page_modified;
+    st.page_slots = page_slots;
+    memcpy(st.page_map, page_map, sizeof(page_map));
+
+    reu_save_page(page_map[current_page]);
+    reu_write(addr, &st, sizeof(st));
+    reu_write(addr + sizeof(st), undo, undo_size);
+    slot_used[doc_slot] = 1;
+}
+
+static void doc_fetch(void) {
+    DocState st;
+    uint16_t undo_size;
+    void *undo = undo_history(&undo_size);
+    REUPtr addr = state_area + (REUPtr)doc_slot * state_stride;
+
+    reu_read(addr, &st, sizeof(st));
+    reu_read(addr + sizeof(st), undo, undo_size);
+
+    strcpy(current_filename, st.filename);
+    file_format = st.format;
+    total_lines = st.total_lines;
+    current_page = st.current_page;
+    num_pages = st.num_pages;
+    cursor_x = st.cursor_x;
+    cursor_y = st.cursor_y;
+    scroll_offset = st.scroll_offset;
+    basic_mode = st.basic_mode;
+    syntax_lang = st.syntax_lang;
+    page_modified = st.page_modified;
+    page_slots = st.page_slots;
+    memcpy(page_map, st.page_map, sizeof(page_map));
+
+    memset(lines, 0, sizeof(lines));
+    hl_invalidate_all();
+    reu_load_page(page_map[current_page]);
+    num_lines = st.num_lines;
+}
+
+static void doc_blank(void) {
+    memset(lines, 0, sizeof(lines));
+    hl_invalidate_all();
+    num_lines = 1;
+    total_lines = 1;
+    current_page = 0;
+    num_pages = 1;
+    cursor_x = 0;
+    cursor_y = 0;
+    scroll_offset = 0;
+    page_modified = 0;
+    basic_mode = 0;
+    syntax_lang = LANG_NONE;
+    current_filename[0] = '\0';
+    file_format = default_format;
+    pages_reset();
+    undo_clear();
+    reu_clear_pages();
+}
+
+void doc_switch(int slot) {
+    int per_slot = reu_total_page_count() / doc_slots;
+    char msg[40];
+
+    if (slot == doc_slot || slot < 0 || slot >= doc_slots) return;
+
+    doc_stash();
+
+    doc_slot = slot;
+    reu_set_page_window(slot * per_slot, per_slot);
+
+    if (slot_used[slot]) {
+        doc_fetch();
+    } else {
+        doc_blank();
+    }
+
+    // A mark belongs to the document it was made in; the clipboard
+    // is shared so text can be carried between documents
+    mark_active = 0;
+
+    update_cursor();
+    sprintf(msg, "DOC %d: %s", slot + 1,
+            current_filename[0] ? current_filename : "(NEW)");
+    show_message(msg, COL_GREEN);
+}
+
+void doc_next(void) {
+    if (doc_slots < 2) {
+        show_message("MORE DOCUMENTS NEED AN REU", COL_RED);
+        return;
+    }
+    doc_switch((doc_slot + 1) % doc_slots);
+}
@@ -0,0 +1,122 @@
+#include "drive.h"
+#include "dircache.h"
+#include "fcache.h"
+#include <string.h>
+
+// One logical file number per drive, so sessions can coexist
+#define DRIVE_FIRST 8
+#define DRIVE_COUNT 8
+#define CMD_LFN(drive) (0x70 + (drive))
+
+// Command buffer of a 1541 holds 40 bytes plus the CR
+#define DOS_CMD_MAX 40
+
+static unsigned char session_open[DRIVE_COUNT];
+static DriveStatus status;
+
+static void drop_session(int drive) {
+    cbm_k_clrch();
+    cbm_k_close(CMD_LFN(drive));
+    session_open[(drive - DRIVE_FIRST) & (DRIVE_COUNT - 1)] = 0;
+}
+
+unsigned char drive_open(int drive) {
+    unsigned char slot = (drive - DRIVE_FIRST) & (DRIVE_COUNT - 1);
+
+    if (session_open[slot]) return 1;
+
+    cbm_k_setlfs(CMD_LFN(drive), drive, 15);
+    cbm_k_setnam("");
+    if (cbm_k_open() != 0) {
+        // Kernal file table full or similar - leave it closed
+        cbm_k_close(CMD_LFN(drive));
+        return 0;
+    }
+    session_open[slot] = 1;
+    return 1;
+}
+
+unsigned char drive_command(int drive, const char *cmd) {
+    if (!drive_open(drive)) return 0;
+
+    if (cbm_k_chkout(CMD_LFN(drive)) != 0) {
+        cbm_k_clrch();
+        return 0;
+    }
+    while (*cmd) {
+        cbm_k_chrout(*cmd++);
+    }
+    cbm_k_chrout(13);
+    cbm_k_clrch();   // UNLISTEN - the drive starts executing here
+    return 1;
+}
+
+unsigned char drive_scratch(int drive, const char *pattern) {
+    char cmd[DOS_CMD_MAX + 1];
+
+    if (strlen(pattern) > DOS_CMD_MAX - 3) return 0;
+    strcpy(cmd, "S0:");
+    strcat(cmd, pattern);
+    return drive_command(drive, cmd);
+}
+
+static unsigned char parse_number(const char **p) {
+    unsigned char n = 0;
+
+    while (**p == ' ') (*p)++;
+    while (**p >= '0' && **p <= '9') {
+        n = n * 10 + (**p - '0');
+        (*p)++;
+    }
+    return n;
+}
+
+const DriveStatus *drive_get_status(int drive) {
+    const char *p;
+    int j = 0;
+    char c;
+
+    status.code = DOS_NO_DEVICE;
+    status.track = 0;
+    status.sector = 0;
+    strcpy(status.text, "DEVICE NOT PRESENT");
+
+    if (!drive_open(drive)) return &status;
+
+    if (cbm_k_chkin(CMD_LFN(drive)) != 0) {
+        drop_session(drive);
+        return &status;
+    }
+    while (j < (int)sizeof(status.text) - 1) {
+        c = cbm_k_chrin();
+        if (cbm_k_readst() & 0x80) {
+            // Device not present - the open session is useless too
+            drop_session(drive);
+            strcpy(status.text, "DEVICE NOT PRESENT");
+            return &status;
+        }
+        if (c == 13) break;
+        status.text[j++] = c;
+        if (cbm_k_readst() & 0x40) break;
+    }
+    status.text[j] = '\0';
+    cbm_k_clrch();
+    if (j == 0) return &status;
+
+    p = status.text;
+    status.code = parse_number(&p);
+    p = strchr(status.text, ',');
+    if (p) p = strchr(p + 1, ',');
+    if (p) {
+        p++;
+        status.track = parse_number(&p);
+        if (*p == ',') p++;
+        status.sector = parse_number(&p);
+    }
+    return &status;
+}
+
+void drive_changed(int drive) {
+    dir_invalidate(drive);
+    fcache_invalidate(drive);
+}
@@ -2,6 +2,11 @@
 #include "editor_state.h"
 #include "screen.h"
 #include "reu.h"
+#include "convert.h"
+#include "file_ops.h"
+#include "drive.h"
+#include "spill.h"
+#include "highlight.h"
 
 void save_current_page_to_temp(void) {
     char temp_name[20];
@@ -12,18 +17,25 @@ void save_current_page_to_temp(void) {
     }
     
     if (reu_is_available()) {
-        reu_save_page(current_page);
+        reu_save_page(page_map[current_page]);
         page_modified = 0;
         return;
     }
     
-    sprintf(temp_name, "@0:%s.P%d,S,W", TEMP_FILE, current_page);
+    // Normally the write happens behind the user's back
+    if (spill_queue(page_map[current_page])) {
+        page_modified = 0;
+        return;
+    }
+
+    sprintf(temp_name, "@0:%s.P%d,S,W", TEMP_FILE, page_map[current_page]);
+    drive_changed(current_drive);
     
-    cbm_k_setlfs(2, current_drive, 2);
+    cbm_k_setlfs(TEMP_LFN, current_drive, TEMP_LFN);
     cbm_k_setnam(temp_name);
     
     if (cbm_k_open() == 0) {
-        cbm_k_chkout(2);
+        cbm_k_chkout(TEMP_LFN);
         
         for (i = 0; i < num_lines; i++) {
             len = strlen(lines[i]);
@@ -36,89 +48,157 @@ void save_current_page_to_temp(void) {
         }
         
         cbm_k_clrch();
-        cbm_k_close(2);
+        cbm_k_close(TEMP_LFN);
         page_modified = 0;
     }
 }
 
-void load_page(int page_num) {
+// Read a page from REU or its temp file into lines[].
+// Returns the number of lines (at least 1).
+int read_page(int page_num) {
     char temp_name[20];
-    int i, pos;
-    unsigned char ch;
-    
-    if (page_num == current_page) return;
-    if (page_num < 0 || page_num >= num_pages) return;
-    
-    save_current_page_to_temp();
-    
-    current_page = page_num;
+    int i = 0, pos = 0, n, k;
+    unsigned char eof = 0;
+    int slot = page_map[page_num];
+
     memset(lines, 0, sizeof(lines));
-    num_lines = 1;
-    
+    hl_invalidate_all();
+
     if (reu_is_available()) {
-        int loaded = reu_load_page(page_num);
-        if (loaded > 0) {
-            num_lines = loaded;
-            page_modified = 0;
-            return;
-        }
+        int loaded = reu_load_page(slot);
+        if (loaded > 0) return loaded;
     }
-    
-    sprintf(temp_name, "%s.P%d,S,R", TEMP_FILE, page_num);
-    
-    cbm_k_setlfs(2, current_drive, 2);
+
+    // A page still waiting to be written is read back from RAM
+    n = spill_read(slot);
+    if (n > 0) return n;
+
+    sprintf(temp_name, "%s.P%d,S,R", TEMP_FILE, slot);
+
+    cbm_k_setlfs(TEMP_LFN, current_drive, TEMP_LFN);
     cbm_k_setnam(temp_name);
-    
+
     if (cbm_k_open() == 0) {
-        i = 0;
-        pos = 0;
-        cbm_k_chkin(2);
-        
-        while (i < LINES_PER_PAGE) {
-            ch = cbm_k_chrin();
-            if (cbm_k_readst() & 0x40) break;
-            
-            if (ch == '\r' || ch == '\n') {
-                lines[i][pos] = '\0';
-                i++;
-                pos = 0;
-            } else if (pos < MAX_LINE_LENGTH - 1) {
-                lines[i][pos++] = ch;
+        conv_begin_input(&raw_format);
+
+        while (!eof && i < LINES_PER_PAGE) {
+            n = read_block(TEMP_LFN, io_buf, IO_BLOCK_SIZE, &eof);
+            for (k = 0; k < n && i < LINES_PER_PAGE; k++) {
+                if (conv_feed(io_buf[k], lines[i], &pos)) {
+                    i++;
+                    pos = 0;
+                }
             }
         }
-        
-        if (pos > 0) {
+
+        if (pos > 0 && i < LINES_PER_PAGE) {
             lines[i][pos] = '\0';
             i++;
         }
-        
-        cbm_k_clrch();
-        cbm_k_close(2);
-        
-        if (i > 0) {
-            num_lines = i;
-        }
+
+        cbm_k_close(TEMP_LFN);
     }
+
+    return i > 0 ? i : 1;
+}
+
+void load_page(int page_num) {
+    if (page_num == current_page) return;
+    if (page_num < 0 || page_num >= num_pages) return;
     
-    if (num_lines < 1) {
-        num_lines = 1;
-    }
+    save_current_page_to_temp();
     
+    current_page = page_num;
+    num_lines = read_page(page_num);
     page_modified = 0;
 }
 
-static void create_new_page(void) {
+// Park the current page in REU/temp so a modal view can borrow lines[]
+static char parked_modified;
+static int parked_num_lines;
+
+void park_page(void) {
+    parked_modified = page_modified;
+    parked_num_lines = num_lines;
+    page_modified = 1;
     save_current_page_to_temp();
-    
+}
+
+void unpark_page(void) {
+    // Temp files drop trailing empty lines - keep the original count
+    read_page(current_page);
+    num_lines = parked_num_lines;
+    page_modified = parked_modified;
+}
+
+// Forget all pages; slots are handed out again from 0
+void pages_reset(void) {
+    int i;
+
+    for (i = 0; i < MAX_PAGES; i++) {
+        page_map[i] = i;
+    }
+    page_slots = 1;
+}
+
+// Make an empty page at position at, moving later pages up by one.
+// Only the map moves; the new page gets a fresh storage slot.
+// Returns 0 if the page store is full.
+int page_insert(int at) {
+    int capacity = reu_is_available() ? reu_max_page_count() : MAX_PAGES;
+
+    if (num_pages >= MAX_PAGES || page_slots >= capacity) return 0;
+
+    memmove(&page_map[at + 1], &page_map[at], num_pages - at);
+    page_map[at] = page_slots++;
     num_pages++;
+    return 1;
+}
+
+// Move lines at.. of the current page to a new page right after it.
+// The current page stays in lines[] with the first at lines.
+int page_split(int at) {
+    int moved = num_lines - at;
+    int head_page = current_page;
+
+    if (at < 1 || moved < 1) return 1;
+    if (!page_insert(current_page + 1)) return 0;
+
+    num_lines = at;
+    page_modified = 1;
+    save_current_page_to_temp();
+
+    memmove(lines[0], lines[at], moved * sizeof(lines[0]));
+    memset(lines[moved], 0, (LINES_PER_PAGE - moved) * sizeof(lines[0]));
+    current_page = head_page + 1;
+    num_lines = moved;
+    page_modified = 1;
+    save_current_page_to_temp();
+
+    current_page = head_page;
+    read_page(current_page);
+    num_lines = at;
+    page_modified = 0;
+    return 1;
+}
+
+static int create_new_page(void) {
+    // Goes right after the current page, which need not be the last
+    if (!page_insert(current_page + 1)) {
+        show_message("PAGE STORE FULL", COL_RED);
+        return 0;
+    }
+    save_current_page_to_temp();
     current_page++;
     
     memset(lines, 0, sizeof(lines));
+    hl_invalidate_all();
     num_lines = 1;
     cursor_x = 0;
     cursor_y = 0;
     scroll_offset = 0;
     page_modified = 1;
+    return 1;
 }
 
 void check_page_boundary(void) {
@@ -141,6 +221,7 @@ void check_page_boundary(void) {
 void init_editor(void) {
     clrscr();
     memset(lines, 0, sizeof(lines));
+    hl_invalidate_all();
     num_lines = 1;
     total_lines = 1;
     current_page = 0;
@@ -155,6 +236,8 @@ void init_editor(void) {
     current_filename[0] = '\0';
     page_modified = 0;
     basic_mode = 0;
+    syntax_lang = LANG_NONE;
+    pages_reset();
     
     POKE(0xD020, 0);
     POKE(0xD021, 0);
@@ -171,11 +254,13 @@ void insert_char(char c) {
         lines[cursor_y][cursor_x] = c;
         cursor_x++;
         page_modified = 1;
+        hl_line_changed(cursor_y);
         
         if (cursor_x >= edit_width && len >= edit_width) {
             if (num_lines < LINES_PER_PAGE) {
                 memmove(&lines[cursor_y + 2], &lines[cursor_y + 1], 
                         (num_lines - cursor_y - 1) * sizeof(lines[0]));
+                hl_line_inserted(cursor_y + 1);
                 
                 strcpy(lines[cursor_y + 1], &lines[cursor_y][edit_width]);
                 lines[cursor_y][edit_width] = '\0';
@@ -202,6 +287,7 @@ void delete_char(void) {
                 len - cursor_x + 1);
         cursor_x--;
         page_modified = 1;
+        hl_line_changed(cursor_y);
     } else if (cursor_y > 0) {
         int prev_len = strlen(lines[cursor_y - 1]);
         if (prev_len + len < MAX_LINE_LENGTH) {
@@ -210,6 +296,8 @@ void delete_char(void) {
             memmove(&lines[cursor_y], &lines[cursor_y + 1], 
                     (num_lines - cursor_y - 1) * sizeof(lines[0]));
             lines[num_lines - 1][0] = '\0';
+            hl_line_deleted(cursor_y);
+            hl_line_changed(cursor_y - 1);
             num_lines--;
             total_lines--;
             
@@ -230,26 +318,35 @@ void new_line(void) {
             char remainder[MAX_LINE_LENGTH];
             strcpy(remainder, &lines[cursor_y][cursor_x]);
             lines[cursor_y][cursor_x] = '\0';
+            hl_line_changed(cursor_y);
             
             page_modified = 1;
-            create_new_page();
+            if (!create_new_page()) {
+                strcat(lines[cursor_y], remainder);
+                return;
+            }
             
             strcpy(lines[0], remainder);
             cursor_x = 0;
             cursor_y = 0;
             total_lines++;
             return;
-        } else {
-            show_message("PAGE FULL - MOVE TO END", COL_YELLOW);
+        }
+
+        // Full page - the lines below the cursor move to a page of their own
+        if (!page_split(cursor_y + 1)) {
+            show_message("PAGE STORE FULL", COL_RED);
             return;
         }
     }
     
     memmove(&lines[cursor_y + 2], &lines[cursor_y + 1], 
             (num_lines - cursor_y - 1) * sizeof(lines[0]));
+    hl_line_inserted(cursor_y + 1);
     
     strcpy(lines[cursor_y + 1], &lines[cursor_y][cursor_x]);
     lines[cursor_y][cursor_x] = '\0';
+    hl_line_changed(cursor_y);
     
     num_lines++;
     total_lines++;
@@ -260,7 +357,4 @@ void new_line(void) {
     if (cursor_y - scroll_offset >= EDIT_HEIGHT) {
         scroll_offset++;
     }
-    
-    num_pages = (total_lines + LINES_PER_PAGE - 1) / LINES_PER_PAGE;
-    if (num_pages < 1) num_pages = 1;
 }
\ No newline at end of file
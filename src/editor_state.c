@@ -17,6 +17,11 @@ int scroll_offset = 0;
 int current_drive = 8;
 char current_filename[17] = "";
 char page_modified = 0;
+unsigned char page_map[MAX_PAGES];
+int page_slots = 1;
+
+// Shared disk block buffer
+unsigned char io_buf[IO_BLOCK_SIZE];
 
 // Search/Replace state - matches header
 char search_term[21];
@@ -30,24 +35,19 @@ int clipboard_lines = 0;
 int mark_active = 0;
 int mark_start_x = 0, mark_start_y = 0;
 int mark_end_x = 0, mark_end_y = 0;
+int mark_start_page = 0, mark_end_page = 0;
 
 // BASIC mode
 int basic_mode = 0;
+unsigned char syntax_lang = LANG_NONE;
 
 // Directory browser
-DirEntry dir_entries[MAX_DIR_ENTRIES];
 int num_dir_entries = 0;
 char disk_name[17];
+char disk_id[3];
+unsigned int blocks_free = 0xFFFF;
 
 // Line number mapping
 LineMapping line_mappings[MAX_LINES];
 int num_mappings = 0;
 
-// BASIC keywords for syntax highlighting
-const char *basic_keywords[] = {
-    "PRINT", "FOR", "NEXT", "IF", "THEN", "GOTO", "GOSUB", "RETURN",
-    "REM", "LET", "DIM", "READ", "DATA", "INPUT", "GET", "POKE",
-    "PEEK", "SYS", "LOAD", "SAVE", "RUN", "LIST", "NEW", "CLR",
-    "AND", "OR", "NOT", "TO", "STEP", "END", "STOP", "RESTORE",
-    NULL
-};
\ No newline at end of file
@@ -0,0 +1,208 @@
+#include "fcache.h"
+#include "reu.h"
+#include <string.h>
+
+#define FC_BLOCK_SIZE 256
+#define FC_MAX_BLOCKS 255
+#define FC_MAX_FILES 16
+#define FC_END 0xFF
+
+typedef struct {
+    unsigned char used;
+    unsigned char drive;
+    char name[17];
+    char disk_id[2];
+    unsigned int blocks;      // block count from the directory
+    uint16_t length;          // bytes stored
+    uint8_t first;            // first cache block of the chain
+    uint16_t stamp;           // last use, for LRU eviction
+} FcEntry;
+
+static REUPtr area;
+static uint8_t num_blocks;
+
+// Block chains; free blocks form one more chain from free_head
+static uint8_t next_block[FC_MAX_BLOCKS];
+static uint8_t free_head = FC_END;
+static uint8_t free_count;
+
+static FcEntry files[FC_MAX_FILES];
+static uint16_t clock;
+
+// Entry being recorded
+static FcEntry *active;
+static uint8_t active_block;
+
+// Read position
+static uint8_t rd_block;
+static uint16_t rd_left;
+
+void fcache_init(void) {
+    uint32_t size;
+    uint8_t i;
+
+    // An eighth of the REU, at most 255 blocks; none on a 128KB REU
+    size = reu_get_size() / 8;
+    if (size > (uint32_t)FC_MAX_BLOCKS * FC_BLOCK_SIZE) {
+        size = (uint32_t)FC_MAX_BLOCKS * FC_BLOCK_SIZE;
+    }
+    if (size < 32768UL) return;
+
+    area = reu_reserve(size);
+    if (!area) return;
+
+    num_blocks = size / FC_BLOCK_SIZE;
+    for (i = 0; i < num_blocks; i++) {
+        next_block[i] = i + 1 < num_blocks ? i + 1 : FC_END;
+    }
+    free_head = 0;
+    free_count = num_blocks;
+}
+
+static void release(FcEntry *e) {
+    uint8_t b = e->first, next;
+
+    while (b != FC_END) {
+        next = next_block[b];
+        next_block[b] = free_head;
+        free_head = b;
+        free_count++;
+        b = next;
+    }
+    e->used = 0;
+}
+
+static FcEntry *find(const DirEntry *entry) {
+    int i;
+
+    for (i = 0; i < FC_MAX_FILES; i++) {
+        FcEntry *e = &files[i];
+        if (e->used && e->drive == current_drive && e->blocks == entry->blocks &&
+            e->disk_id[0] == disk_id[0] && e->disk_id[1] == disk_id[1] &&
+            strcmp(e->name, entry->name) == 0) {
+            return e;
+        }
+    }
+    return NULL;
+}
+
+unsigned char fcache_open(const DirEntry *entry) {
+    FcEntry *e = area ? find(entry) : NULL;
+
+    if (!e) return 0;
+
+    e->stamp = ++clock;
+    rd_block = e->first;
+    rd_left = e->length;
+    return 1;
+}
+
+int fcache_read(unsigned char *buf, unsigned char *eof) {
+    int n = rd_left > IO_BLOCK_SIZE ? IO_BLOCK_SIZE : rd_left;
+
+    if (n > 0) {
+        reu_read(area + (REUPtr)rd_block * FC_BLOCK_SIZE, buf, n);
+        rd_block = next_block[rd_block];
+        rd_left -= n;
+    }
+    *eof = rd_left == 0;
+    return n;
+}
+
+static FcEntry *least_recent(void) {
+    FcEntry *oldest = NULL;
+    int i;
+
+    for (i = 0; i < FC_MAX_FILES; i++) {
+        if (files[i].used && (!oldest || files[i].stamp < oldest->stamp)) {
+            oldest = &files[i];
+        }
+    }
+    return oldest;
+}
+
+void fcache_record(const DirEntry *entry) {
+    FcEntry *e;
+    uint8_t b, need;
+    int i;
+
+    fcache_abort();
+    if (!area || entry->blocks == 0 || entry->blocks > num_blocks) return;
+
+    e = find(entry);
+    if (e) release(e);
+
+    // Evict least recently used files until the chain fits
+    need = entry->blocks;
+    while (free_count < need) {
+        release(least_recent());
+    }
+
+    e = NULL;
+    for (i = 0; i < FC_MAX_FILES && !e; i++) {
+        if (!files[i].used) e = &files[i];
+    }
+    if (!e) {
+        e = least_recent();
+        release(e);
+    }
+
+    // Take the chain off the free list
+    e->first = free_head;
+    b = free_head;
+    for (i = 1; i < need; i++) b = next_block[b];
+    free_head = next_block[b];
+    next_block[b] = FC_END;
+    free_count -= need;
+
+    e->drive = current_drive;
+    strcpy(e->name, entry->name);
+    e->disk_id[0] = disk_id[0];
+    e->disk_id[1] = disk_id[1];
+    e->blocks = entry->blocks;
+    e->length = 0;
+    active = e;
+    active_block = e->first;
+}
+
+void fcache_write(const unsigned char *buf, int len) {
+    if (!active || len == 0) return;
+
+    // The directory undercounted - give up on this file
+    if (active_block == FC_END) {
+        fcache_abort();
+        return;
+    }
+    reu_write(area + (REUPtr)active_block * FC_BLOCK_SIZE, (void *)buf, len);
+    active_block = next_block[active_block];
+    active->length += len;
+}
+
+void fcache_commit(void) {
+    if (!active) return;
+
+    // Shorter than the directory says - the read stopped on an error
+    if (active->length <= (uint16_t)(active->blocks - 1) * IO_BLOCK_SIZE) {
+        fcache_abort();
+        return;
+    }
+    active->used = 1;
+    active->stamp = ++clock;
+    active = NULL;
+}
+
+void fcache_abort(void) {
+    if (!active) return;
+    release(active);
+    active = NULL;
+}
+
+void fcache_invalidate(int drive) {
+    int i;
+
+    for (i = 0; i < FC_MAX_FILES; i++) {
+        if (files[i].used && files[i].drive == drive) {
+            release(&files[i]);
+        }
+    }
+}
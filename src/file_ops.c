@@ -4,18 +4,29 @@
 #include "screen.h"
 #include "mouse.h"
 #include "reu.h"
+#include "convert.h"
+#include "pager.h"
+#include "hexview.h"
+#include "dircache.h"
+#include "drive.h"
+#include "spill.h"
+#include "undo.h"
+#include "fcache.h"
+#include "blockio.h"
+#include "highlight.h"
 
-// Compact extension table
+// Compact extension table: extension, file type, highlighting language
+// (A = 6502 assembler, C = C, space = none)
 static const char ext_table[] = 
-    "C  S" "H  S" "TXTS" "BASS" "ASMS" "S  S" "INCS" 
-    "CFGS" "MD S" "DOCS" "LOGS" "INIS" "XMLS" "JSNS"
-    "CSVS" "DATS" "PRGP" "BINP" "A65S" "CC S" "CPPS"
-    "SEQS" "USRU" "RELR" "DELD" "\0";
+    "C  SC" "H  SC" "TXTS " "BASS " "ASMSA" "S  SA" "INCSA" 
+    "CFGS " "MD S " "DOCS " "LOGS " "INIS " "XMLS " "JSNS "
+    "CSVS " "DATS " "PRGP " "BINP " "A65SA" "CC SC" "CPPSC"
+    "SEQS " "USRU " "RELR " "DELD " "\0";
 
-// Optimized extension checking - uses much less memory
-static char check_ext_type(const char* filename) {
+// Table entry for a file name's extension, NULL if it has none we know
+static const char *ext_entry(const char* filename) {
     int len = strlen(filename);
-    if (len < 2) return 'P'; // Default PRG
+    if (len < 2) return NULL;
     
     // Find last dot
     const char* ext = NULL;
@@ -26,7 +37,7 @@ static char check_ext_type(const char* filename) {
         }
     }
     
-    if (!ext) return 'P'; // No extension = PRG
+    if (!ext) return NULL;
     
     // Convert first 3 chars of extension to uppercase
     char ext_up[4];
@@ -41,56 +52,108 @@ static char check_ext_type(const char* filename) {
     const char* p = ext_table;
     while (*p) {
         if (p[0] == ext_up[0] && p[1] == ext_up[1] && p[2] == ext_up[2]) {
-            return p[3]; // Return type character
+            return p;
         }
-        p += 4; // Move to next entry
+        p += 5; // Move to next entry
     }
     
-    return 'P'; // Default PRG for unknown
+    return NULL;
+}
+
+// Optimized extension checking - uses much less memory
+static char check_ext_type(const char* filename) {
+    const char *e = ext_entry(filename);
+    return e ? e[3] : 'P'; // Default PRG for unknown
+}
+
+// Highlighting language for a file name
+static unsigned char ext_lang(const char *filename) {
+    const char *e = ext_entry(filename);
+    if (e && e[4] == 'A') return LANG_ASM;
+    if (e && e[4] == 'C') return LANG_C;
+    return LANG_NONE;
+}
+
+// Read up to max bytes from an open logical file. Sets *eof at end of
+// file or on a bus error. The byte that arrives with EOI is still valid.
+int read_block(unsigned char lfn, unsigned char *buf, int max, unsigned char *eof) {
+    int n = 0;
+    unsigned char ch, st;
+
+    *eof = 0;
+    cbm_k_chkin(lfn);
+    while (n < max) {
+        ch = cbm_k_chrin();
+        st = cbm_k_readst();
+        if (st & 0xBF) {
+            *eof = 1;
+            break;
+        }
+        buf[n++] = ch;
+        if (st & 0x40) {
+            *eof = 1;
+            break;
+        }
+    }
+    cbm_k_clrch();
+    return n;
 }
 
 void select_drive() {
     char msg[40];
     char c;
+    int drive = 0;
     
     sprintf(msg, "DRIVE (8-15) [NOW:%d]: ", current_drive);
     show_message(msg, COL_YELLOW);
     
     c = cgetc();
     if (c >= '8' && c <= '9') {
-        current_drive = c - '0';
-        sprintf(msg, "DRIVE=%d", current_drive);
-        show_message(msg, COL_GREEN);
+        drive = c - '0';
     } else if (c == '1') {
         c = cgetc();
         if (c >= '0' && c <= '5') {
-            current_drive = 10 + (c - '0');
-            sprintf(msg, "DRIVE=%d", current_drive);
-            show_message(msg, COL_GREEN);
-        } else {
-            show_message("CANCELLED", COL_RED);
+            drive = 10 + (c - '0');
         }
-    } else {
+    }
+
+    if (drive == 0) {
         show_message("CANCELLED", COL_RED);
+    } else if (drive_get_status(drive)->code == DOS_NO_DEVICE) {
+        // Opening the session doubles as the presence check
+        sprintf(msg, "DRIVE %d NOT PRESENT", drive);
+        show_message(msg, COL_RED);
+    } else {
+        // Temp pages live on the old drive - finish writing them first
+        spill_flush();
+        current_drive = drive;
+        sprintf(msg, "DRIVE=%d", current_drive);
+        show_message(msg, COL_GREEN);
     }
     
     update_cursor();
 }
 
-void load_directory() {
+void load_directory(const char *pattern) {
     unsigned char c;
     char line_buf[40];
     int line_pos = 0;
     int in_name = 0;
     unsigned char file_type_byte;
+    DirRecord rec;
+    int header = 1;
     
-    num_dir_entries = 0;
+    dir_begin(current_drive, pattern);
     disk_name[0] = '\0';
+    disk_id[0] = '\0';
+    blocks_free = 0xFFFF;
     
     show_message("READING DIR...", COL_YELLOW);
     
+    // A pattern makes the drive do the filtering: "$:*.TXT"
+    sprintf(line_buf, "$:%s", pattern);
     cbm_k_setlfs(2, current_drive, 0);
-    cbm_k_setnam("$");
+    cbm_k_setnam(pattern[0] ? line_buf : "$");
     
     if (cbm_k_open() != 0) {
         show_message("DIR ERROR", COL_RED);
@@ -102,7 +165,7 @@ void load_directory() {
     cbm_k_chrin();
     cbm_k_chrin();
     
-    while (num_dir_entries < MAX_DIR_ENTRIES - 1) {
+    while (1) {
         int link_lo = cbm_k_chrin();
         int link_hi = cbm_k_chrin();
         
@@ -141,49 +204,51 @@ void load_directory() {
         }
         line_buf[line_pos] = '\0';
         
-        if (num_dir_entries == 0 && blocks == 0) {
+        if (header) {
+            char *q = strrchr(full_line, '"');
+
             strncpy(disk_name, line_buf, 16);
             disk_name[16] = '\0';
+
+            // Header ends in ' ID 2A' - the ID tells swapped disks apart
+            if (q && strlen(q) >= 4) {
+                disk_id[0] = q[2];
+                disk_id[1] = q[3];
+                disk_id[2] = '\0';
+            }
+            header = 0;
             continue;
         }
         
+        // Unquoted trailer is the "BLOCKS FREE." line
         if (line_buf[0] == '\0') {
+            blocks_free = blocks;
             break;
         }
         
         // Determine file type - check native CBM types first
-        const char* type_str = "PRG";
         file_type_byte = 0x82;
         
         if (strstr(full_line, "DEL")) {
-            type_str = "DEL";
             file_type_byte = 0x80;
         } else if (strstr(full_line, "SEQ")) {
-            type_str = "SEQ";
             file_type_byte = 0x81;
         } else if (strstr(full_line, "PRG")) {
-            type_str = "PRG";
             file_type_byte = 0x82;
         } else if (strstr(full_line, "USR")) {
-            type_str = "USR";
             file_type_byte = 0x83;
         } else if (strstr(full_line, "REL")) {
-            type_str = "REL";
             file_type_byte = 0x84;
         } else {
             // Check extension for file type
             char ext_type = check_ext_type(line_buf);
             if (ext_type == 'S') {
-                type_str = "SEQ";
                 file_type_byte = 0x81;
             } else if (ext_type == 'U') {
-                type_str = "USR";
                 file_type_byte = 0x83;
             } else if (ext_type == 'R') {
-                type_str = "REL";
                 file_type_byte = 0x84;
             } else if (ext_type == 'D') {
-                type_str = "DEL";
                 file_type_byte = 0x80;
             }
         }
@@ -192,197 +257,458 @@ void load_directory() {
             file_type_byte |= 0x40;
         }
         
-        strncpy(dir_entries[num_dir_entries].name, line_buf, 16);
-        dir_entries[num_dir_entries].name[16] = '\0';
-        dir_entries[num_dir_entries].blocks = blocks;
-        strcpy(dir_entries[num_dir_entries].type, type_str);
+        memset(&rec, 0, sizeof(rec));
+        memcpy(rec.name, line_buf, line_pos);
+        rec.blocks = blocks;
+        rec.type = file_type_byte;
         
-        if (file_type_byte & 0x40) {
-            strcat(dir_entries[num_dir_entries].type, "*");
-        }
-        
-        num_dir_entries++;
+        if (!dir_add(&rec)) break;
     }
     
     cbm_k_clrch();
     cbm_k_close(2);
+    dir_end();
 }
 
-void show_directory() {
-    int i, selected = 0, scroll_pos = 0;
-    char c;
+static void prompt_pattern(void) {
+    char pattern[17];
+    int i = 0;
+
+    show_message("PATTERN (E.G. *.TXT): ", COL_YELLOW);
+    while (1) {
+        char c = cgetc();
+        if (c == KEY_RETURN) break;
+        if (c == KEY_STOP) return;
+        if (c == KEY_DELETE && i > 0) {
+            i--;
+            cputc_at(22 + i, 24, ' ', COL_YELLOW);
+        } else if (c > 32 && c < 128 && i < 16) {
+            pattern[i] = c;
+            cputc_at(22 + i, 24, c, COL_YELLOW);
+            i++;
+        }
+    }
+    pattern[i] = '\0';
+
+    load_directory(pattern);
+}
+
+// Reset editor state to an empty, unnamed document
+static void reset_document(void) {
+    memset(lines, 0, sizeof(lines));
+    hl_invalidate_all();
+    syntax_lang = LANG_NONE;
+    num_lines = 1;
+    total_lines = 1;
+    current_page = 0;
+    num_pages = 1;
+    pages_reset();
+    cursor_x = 0;
+    cursor_y = 0;
+    scroll_offset = 0;
+    page_modified = 0;
+    current_filename[0] = '\0';
+    file_format = default_format;
     
-    load_directory();
+    // Clear search/replace
+    search_term[0] = '\0';
+    replace_term[0] = '\0';
+    search_line = 0;
+    search_pos = 0;
     
-    if (num_dir_entries == 0) {
-        show_message("NO FILES - CHECK DRIVE (F3)", COL_RED);
-        return;
+    // Clear clipboard and marks
+    clipboard_lines = 0;
+    mark_active = 0;
+    undo_clear();
+}
+
+// Build the OPEN name for a directory entry
+void dir_open_name(const DirEntry *entry, char *buf) {
+    // Determine how to open based on the CBM file type from directory
+    if (strcmp(entry->type, "SEQ") == 0) {
+        sprintf(buf, "%s,S,R", entry->name);
+    } else {
+        // For PRG and other types, also open as data channel
+        sprintf(buf, "%s,P,R", entry->name);
     }
-    
-    while (1) {
-        clrscr();
-        
-        char title[40];
-        sprintf(title, "DIRECTORY - DRIVE %d", current_drive);
-        cputs_at(2, 0, title, COL_YELLOW);
-        
-        if (disk_name[0]) {
-            int name_len = strlen(disk_name);
-            int start_x = (40 - name_len) / 2;
-            cputs_at(start_x, 1, disk_name, COL_CYAN);
-        }
-        
-        for (i = 0; i < 40; i++) {
-            cputc_at(i, 2, '-', COL_CYAN);
+}
+
+// Room for this many pages in the page store while loading entry?
+static int page_store_has_room(int pages, const DirEntry *entry) {
+    if (pages > MAX_PAGES) return 0;
+    if (reu_is_available()) {
+        return pages <= reu_max_page_count();
+    }
+    // Temp pages need about as many blocks as the file itself
+    return entry->blocks < blocks_free;
+}
+
+// PRG/USR entries without a text extension are probably binary
+static unsigned char prg_like(const DirEntry *entry) {
+    if (strncmp(entry->type, "PRG", 3) != 0 &&
+        strncmp(entry->type, "USR", 3) != 0) {
+        return 0;
+    }
+    return check_ext_type(entry->name) != 'S';
+}
+
+#define LOAD_ERROR   0
+#define LOAD_OK      1
+#define LOAD_TOO_BIG 2
+#define LOAD_BINARY  3
+
+// Source of load_file's blocks: the REU file cache when it holds the
+// file, otherwise the drive, with each block copied into the cache
+static unsigned char load_cached;
+
+static int load_block(unsigned char *eof) {
+    int n;
+
+    if (load_cached) return fcache_read(io_buf, eof);
+
+    n = read_block(2, io_buf, IO_BLOCK_SIZE, eof);
+    fcache_write(io_buf, n);
+    return n;
+}
+
+static void load_close(void) {
+    if (!load_cached) cbm_k_close(2);
+}
+
+// Load a file through the conversion pipeline, distributing its lines
+// over pages in REU or temp files. Returns LOAD_TOO_BIG if the page
+// store runs out of room; the document is then already replaced.
+static int load_file(const DirEntry *entry) {
+    char load_name[30];
+    int line = 0, pos = 0, page = 0;
+    int n, k;
+    unsigned char eof;
+
+    load_cached = fcache_open(entry);
+    if (load_cached) {
+        show_message("LOADING FROM REU...", COL_YELLOW);
+    } else {
+        dir_open_name(entry, load_name);
+
+        cbm_k_setlfs(2, current_drive, 2);
+        cbm_k_setnam(load_name);
+
+        if (cbm_k_open() != 0) {
+            return LOAD_ERROR;
         }
-        
-        cputs_at(1, 3, "BLK  FILENAME         TYPE", COL_CYAN);
-        
-        for (i = scroll_pos; i < scroll_pos + 18 && i < num_dir_entries; i++) {
-            unsigned char color;
-            char line[40];
-            
-            if (i == selected) {
-                color = COL_GREEN;
-                for (int x = 0; x < 40; x++) {
-                    cputc_at(x, i - scroll_pos + 4, ' ', COL_GREEN);
+        fcache_record(entry);
+    }
+
+    // Binary files go to the hex view; the document is left untouched
+    n = load_block(&eof);
+    if (conv_is_binary(io_buf, n, prg_like(entry))) {
+        fcache_abort();
+        load_close();
+        return LOAD_BINARY;
+    }
+
+    memset(lines, 0, sizeof(lines));
+    hl_invalidate_all();
+    pages_reset();
+
+    // Charset and line endings are decided from the first block
+    conv_detect(io_buf, n, &file_format);
+    conv_begin_input(&file_format);
+
+    while (n > 0) {
+        for (k = 0; k < n; k++) {
+            if (!conv_feed(io_buf[k], lines[line], &pos)) continue;
+
+            line++;
+            pos = 0;
+
+            // Page full - save to REU/temp and start next page
+            if (line >= LINES_PER_PAGE) {
+                if (!page_store_has_room(page + 2, entry)) {
+                    fcache_abort();
+                    load_close();
+                    return LOAD_TOO_BIG;
                 }
-            } else {
-                color = COL_WHITE;
+                num_lines = line;
+                current_page = page;
+                page_modified = 1;
+                save_current_page_to_temp();
+                page++;
+                line = 0;
+                memset(lines, 0, sizeof(lines));
             }
-            
-            sprintf(line, "%4d  %-16s  %s", 
-                    dir_entries[i].blocks, 
-                    dir_entries[i].name,
-                    dir_entries[i].type);
-            cputs_at(1, i - scroll_pos + 4, line, color);
         }
-        
-        cputs_at(0, 22, "                                        ", COL_BLUE);
-        char info[40];
-        sprintf(info, "%d FILES", num_dir_entries);
-        cputs_at(1, 22, info, COL_BLUE);
-        
-        cputs_at(0, 23, " \x91=UP \x11=DOWN  RETURN=LOAD  STOP=EXIT", COL_CYAN);
-        
-        c = cgetc();
-        
-        if (c == KEY_UP && selected > 0) {
-            selected--;
-            if (selected < scroll_pos) scroll_pos = selected;
-        } else if (c == KEY_DOWN && selected < num_dir_entries - 1) {
-            selected++;
-            if (selected >= scroll_pos + 18) scroll_pos = selected - 17;
-        } else if (c == KEY_RETURN) {
-            show_message("LOADING...", COL_YELLOW);
+        if (eof) break;
+        n = load_block(&eof);
+    }
 
-            // Determine how to open based on the CBM file type from directory
-            char load_name[30];
-            if (strcmp(dir_entries[selected].type, "SEQ") == 0) {
-                sprintf(load_name, "%s,S,R", dir_entries[selected].name);
-            } else {
-                // For PRG and other types, also open as data channel
-                sprintf(load_name, "%s,P,R", dir_entries[selected].name);
-            }
+    load_close();
+    fcache_commit();
 
-            cbm_k_setlfs(2, current_drive, 2);
-            cbm_k_setnam(load_name);
-            
-            if (cbm_k_open() == 0) {
-                int line = 0, pos = 0;
-                int page = 0;
-                int total = 0;
-                unsigned char ch;
-                unsigned char eof = 0;
+    // Save final partial line
+    if (pos > 0 || line == 0) {
+        lines[line][pos] = '\0';
+        line++;
+    }
 
-                memset(lines, 0, sizeof(lines));
-                cbm_k_chkin(2);
-
-                while (!eof) {
-                    ch = cbm_k_chrin();
-                    if (cbm_k_readst() & 0x40) {
-                        eof = 1;
-                        // Save final partial line
-                        if (pos > 0 || line == 0) {
-                            lines[line][pos] = '\0';
-                            line++;
-                        }
-                        break;
-                    }
-
-                    if (ch == '\r' || ch == '\n') {
-                        lines[line][pos] = '\0';
-                        line++;
-                        total++;
-                        pos = 0;
-
-                        // Page full - save to REU/temp and start next page
-                        if (line >= LINES_PER_PAGE) {
-                            num_lines = line;
-                            current_page = page;
-                            page_modified = 1;
-                            if (reu_is_available()) {
-                                reu_save_page(page);
-                            } else {
-                                save_current_page_to_temp();
-                            }
-                            page++;
-                            line = 0;
-                            pos = 0;
-                            memset(lines, 0, sizeof(lines));
-                        }
-                    } else if (pos < MAX_LINE_LENGTH - 1) {
-                        lines[line][pos++] = ch;
-                    }
-                }
+    // Final page stays in lines buffer
+    num_lines = line;
+    num_pages = page + 1;
+    page_slots = num_pages;
+    current_page = page;
+    total_lines = page * LINES_PER_PAGE + num_lines;
+    cursor_x = 0;
+    cursor_y = 0;
+    scroll_offset = 0;
+    page_modified = 0;
 
-                cbm_k_clrch();
-                cbm_k_close(2);
-
-                // Final page stays in lines buffer
-                num_lines = line > 0 ? line : 1;
-                total += num_lines;
-                num_pages = page + 1;
-                current_page = 0;
-                total_lines = total;
-                cursor_x = 0;
-                cursor_y = 0;
-                scroll_offset = 0;
-                page_modified = 0;
-
-                // If multi-page, save the last page and load page 0
-                if (num_pages > 1) {
-                    // Save the last page we just read
-                    current_page = page;
-                    page_modified = 1;
-                    if (reu_is_available()) {
-                        reu_save_page(page);
-                    } else {
-                        save_current_page_to_temp();
-                    }
-                    // Load page 0 for display
-                    memset(lines, 0, sizeof(lines));
-                    current_page = 0;
-                    if (reu_is_available()) {
-                        int loaded = reu_load_page(0);
-                        if (loaded > 0) num_lines = loaded;
-                    }
-                    page_modified = 0;
-                }
+    // If multi-page, save the last page and load page 0 for display
+    if (num_pages > 1) {
+        page_modified = 1;
+        load_page(0);
+    }
 
-                strcpy(current_filename, dir_entries[selected].name);
+    strcpy(current_filename, entry->name);
+    syntax_lang = ext_lang(current_filename);
+    return LOAD_OK;
+}
+
+// Directory browser layout
+#define DIR_LIST_TOP 4
+#define DIR_LIST_ROWS 17
+#define DIR_INFO_ROW 21
+
+static int dir_sel, dir_top;
+static unsigned char dir_sort = SORT_DISK;
+static char dir_filter[17];
+static int dir_filter_len;
+
+static void dir_draw_row(int pos) {
+    static DirEntry e;
+    char line[41];
+
+    if (pos < dir_view_count()) {
+        dir_view_get(pos, &e);
+        sprintf(line, " %4d  %-16s  %-4s", e.blocks, e.name, e.type);
+    } else {
+        line[0] = '\0';
+    }
+    // Pad to the full row so no clearing pass is needed
+    sprintf(line + strlen(line), "%*s", 40 - (int)strlen(line), "");
+    cputs_at(0, DIR_LIST_TOP + pos - dir_top, line,
+             pos == dir_sel ? COL_GREEN : COL_WHITE);
+}
 
+static void dir_draw_list(void) {
+    int i;
+
+    for (i = 0; i < DIR_LIST_ROWS; i++) {
+        dir_draw_row(dir_top + i);
+    }
+}
+
+static void dir_draw_info(void) {
+    char info[64];
+
+    if (num_dir_entries == 0) {
+        strcpy(info, " NO FILES");
+    } else {
+        sprintf(info, " %d/%d %s%s %s%s", dir_view_count(), num_dir_entries,
+                dir_sort_name(dir_sort), dir_truncated() ? " TRUNC" : "",
+                dir_filter_len ? "FIND:" : "", dir_filter);
+        info[40] = '\0';
+    }
+    sprintf(info + strlen(info), "%*s", 40 - (int)strlen(info), "");
+    cputs_at(0, DIR_INFO_ROW, info, COL_BLUE);
+}
+
+static void dir_draw_all(void) {
+    char title[40];
+    int i;
+
+    clrscr();
+
+    if (dir_pattern[0]) {
+        sprintf(title, "DIRECTORY - DRIVE %d  %s", current_drive, dir_pattern);
+    } else {
+        sprintf(title, "DIRECTORY - DRIVE %d", current_drive);
+    }
+    cputs_at(2, 0, title, COL_YELLOW);
+
+    if (disk_name[0]) {
+        int name_len = strlen(disk_name);
+        int start_x = (40 - name_len) / 2;
+        cputs_at(start_x, 1, disk_name, COL_CYAN);
+    }
+
+    for (i = 0; i < 40; i++) {
+        cputc_at(i, 2, '-', COL_CYAN);
+    }
+
+    cputs_at(1, 3, "BLK  FILENAME         TYPE", COL_CYAN);
+    dir_draw_list();
+    dir_draw_info();
+    cputs_at(0, 22, " RETURN=LOAD  F2=INSERT AT CURSOR", COL_CYAN);
+    cputs_at(0, 23, " F1=READ F3=SORT F5=PAT F7=VIEW F8=HEX", COL_CYAN);
+}
+
+// Rebuild the view after the listing, sort order or filter changed
+static void dir_refresh(unsigned char narrow) {
+    if (num_dir_entries > 100) show_message("SORTING...", COL_YELLOW);
+    if (narrow) {
+        dir_narrow(dir_filter);
+    } else {
+        dir_view(dir_filter, dir_sort);
+    }
+    dir_sel = 0;
+    dir_top = 0;
+    dir_draw_list();
+    dir_draw_info();
+    if (num_dir_entries > 100) show_message("", COL_CYAN);
+}
+
+// Move the highlight; only the two affected rows are redrawn, and a
+// one-row scroll shifts the list instead of redrawing it
+static void dir_move(int to) {
+    int old = dir_sel;
+
+    if (to < 0) to = 0;
+    if (to >= dir_view_count()) to = dir_view_count() - 1;
+    if (to == old || to < 0) return;
+    dir_sel = to;
+
+    if (to >= dir_top && to < dir_top + DIR_LIST_ROWS) {
+        dir_draw_row(old);
+        dir_draw_row(to);
+    } else if (to == dir_top + DIR_LIST_ROWS) {
+        dir_top++;
+        scroll_rows(DIR_LIST_TOP, DIR_LIST_TOP + DIR_LIST_ROWS - 1, 1);
+        dir_draw_row(old);
+        dir_draw_row(to);
+    } else if (to == dir_top - 1) {
+        dir_top--;
+        scroll_rows(DIR_LIST_TOP, DIR_LIST_TOP + DIR_LIST_ROWS - 1, -1);
+        dir_draw_row(old);
+        dir_draw_row(to);
+    } else {
+        dir_top = to < dir_top ? to : to - DIR_LIST_ROWS + 1;
+        dir_draw_list();
+    }
+}
+
+static void dir_reload(const char *pattern) {
+    if (pattern) {
+        load_directory(pattern);
+    } else {
+        prompt_pattern();
+    }
+    dir_filter_len = 0;
+    dir_filter[0] = '\0';
+    dir_view("", dir_sort);
+    dir_sel = 0;
+    dir_top = 0;
+    dir_draw_all();
+}
+
+void show_directory() {
+    char c;
+    static DirEntry entry;
+    
+    screen_modal_begin();
+
+    // Listings are cached per drive until something is written to it
+    spill_flush();
+    if (!dir_select(current_drive)) {
+        load_directory("");
+    }
+
+    dir_filter_len = 0;
+    dir_filter[0] = '\0';
+    dir_view("", dir_sort);
+    dir_sel = 0;
+    dir_top = 0;
+    dir_draw_all();
+    
+    while (1) {
+        c = cgetc();
+        
+        if (c == KEY_UP) {
+            dir_move(dir_sel - 1);
+        } else if (c == KEY_DOWN) {
+            dir_move(dir_sel + 1);
+        } else if (c == KEY_LEFT) {
+            dir_move(dir_sel - DIR_LIST_ROWS);
+        } else if (c == KEY_RIGHT) {
+            dir_move(dir_sel + DIR_LIST_ROWS);
+        } else if (c == KEY_HOME) {
+            dir_move(0);
+        } else if (c == KEY_F1) {
+            // Re-read, e.g. after a disk swap
+            dir_reload(dir_pattern);
+        } else if (c == KEY_F5) {
+            // Ask the drive for a filtered listing
+            dir_reload(NULL);
+        } else if (c == KEY_F3) {
+            dir_sort = (dir_sort + 1) & 3;
+            dir_refresh(0);
+        } else if (c == KEY_DELETE) {
+            if (dir_filter_len > 0) {
+                dir_filter[--dir_filter_len] = '\0';
+                dir_refresh(0);
+            }
+        } else if (c > 32 && c < 128 && c != '"' && dir_filter_len < 16) {
+            // Type-ahead: each key narrows the current view
+            dir_filter[dir_filter_len++] = c;
+            dir_filter[dir_filter_len] = '\0';
+            dir_refresh(1);
+        } else if (c == 3) {
+            screen_modal_end();
+            show_message("CANCELLED", COL_RED);
+            return;
+        } else if (dir_view_count() == 0) {
+            continue;
+        } else if (c == KEY_RETURN) {
+            show_message("LOADING...", COL_YELLOW);
+
+            dir_view_get(dir_sel, &entry);
+            int result = load_file(&entry);
+
+            if (result == LOAD_BINARY) {
+                hexview_edit(&entry);
+                return;
+            } else if (result == LOAD_TOO_BIG) {
+                // Too big for the page store - fall back to read-only view
+                reset_document();
+                pager_view(&entry);
+                return;
+            } else if (result == LOAD_OK) {
                 update_cursor();
                 char lmsg[40];
-                sprintf(lmsg, "LOADED %d LINES %d PAGES", total_lines, num_pages);
+                sprintf(lmsg, "LOADED %d LINES %d PAGES %s", total_lines,
+                        num_pages, conv_format_name(&file_format));
                 show_message(lmsg, COL_GREEN);
                 return;
             } else {
-                show_message("ERROR LOADING", COL_RED);
+                const DriveStatus *st = drive_get_status(current_drive);
+
+                // The listing may be stale (disk swapped)
+                if (st->code == DOS_FILE_NOT_FOUND) {
+                    drive_changed(current_drive);
+                }
+                show_message(drive_ok(st) ? "ERROR LOADING" : st->text, COL_RED);
             }
-        } else if (c == 3) {
+        } else if (c == KEY_F2) {
+            dir_view_get(dir_sel, &entry);
             update_cursor();
-            show_message("CANCELLED", COL_RED);
+            insert_file(&entry);
+            return;
+        } else if (c == KEY_F8) {
+            dir_view_get(dir_sel, &entry);
+            hexview_edit(&entry);
+            return;
+        } else if (c == KEY_F7) {
+            dir_view_get(dir_sel, &entry);
+            pager_view(&entry);
             return;
         }
     }
@@ -392,10 +718,12 @@ void save_file() {
     char filename[20];
     char full_filename[30];
     char msg[40];
-    int i, len;
+    int i;
     int overwrite = 0;
+    const DriveStatus *st;
     
     save_current_page_to_temp();
+    spill_flush();
     
     if (current_filename[0] != '\0') {
         sprintf(msg, "SAVE AS [%s]: ", current_filename);
@@ -467,6 +795,7 @@ void save_file() {
     show_message("SAVING...", COL_YELLOW);
 
     sprintf(full_filename, "@0:%s,S,W", filename);
+    drive_changed(current_drive);
 
     cbm_k_setlfs(2, current_drive, 2);
     cbm_k_setnam(full_filename);
@@ -477,78 +806,36 @@ void save_file() {
     }
 
     cbm_k_chkout(2);
+    conv_begin_output(&file_format);
 
     // Write all pages to file
     if (num_pages > 1) {
         int saved_page = current_page;
-        int first_line_written = 0;
 
         // Current page was saved to REU/temp by save_current_page_to_temp above
         for (int p = 0; p < num_pages; p++) {
-            int page_lines;
-
             // Load each page from REU/temp into lines buffer
-            memset(lines, 0, sizeof(lines));
-            if (reu_is_available()) {
-                page_lines = reu_load_page(p);
-                if (page_lines <= 0) page_lines = 1;
-            } else {
-                char temp_name[20];
-                sprintf(temp_name, "%s.P%d,S,R", TEMP_FILE, p);
-                cbm_k_setlfs(3, current_drive, 2);
-                cbm_k_setnam(temp_name);
-                page_lines = 1;
-                if (cbm_k_open() == 0) {
-                    int li = 0, po = 0;
-                    unsigned char ch;
-                    cbm_k_chkin(3);
-                    while (li < LINES_PER_PAGE) {
-                        ch = cbm_k_chrin();
-                        if (cbm_k_readst() & 0x40) break;
-                        if (ch == '\r' || ch == '\n') {
-                            lines[li][po] = '\0';
-                            li++; po = 0;
-                        } else if (po < MAX_LINE_LENGTH - 1) {
-                            lines[li][po++] = ch;
-                        }
-                    }
-                    if (po > 0) { lines[li][po] = '\0'; li++; }
-                    cbm_k_clrch();
-                    cbm_k_close(3);
-                    if (li > 0) page_lines = li;
-                }
-            }
+            int page_lines = read_page(p);
 
             // Write this page's lines to the output file
             cbm_k_chkout(2);
             for (i = 0; i < page_lines; i++) {
-                if (first_line_written) {
-                    cbm_k_chrout(13);
+                if (p > 0 || i > 0) {
+                    conv_write_eol();
                 }
-                len = strlen(lines[i]);
-                for (int j = 0; j < len; j++) {
-                    cbm_k_chrout(lines[i][j]);
-                }
-                first_line_written = 1;
+                conv_write_line(lines[i]);
             }
         }
 
         // Restore the page the user was on
-        memset(lines, 0, sizeof(lines));
-        if (reu_is_available()) {
-            int loaded = reu_load_page(saved_page);
-            if (loaded > 0) num_lines = loaded;
-        }
+        num_lines = read_page(saved_page);
         current_page = saved_page;
     } else {
         // Single page - write directly from current lines buffer
         for (i = 0; i < num_lines; i++) {
-            len = strlen(lines[i]);
-            for (int j = 0; j < len; j++) {
-                cbm_k_chrout(lines[i][j]);
-            }
+            conv_write_line(lines[i]);
             if (i < num_lines - 1) {
-                cbm_k_chrout(13);
+                conv_write_eol();
             }
         }
     }
@@ -556,42 +843,18 @@ void save_file() {
     cbm_k_clrch();
     cbm_k_close(2);
     
-    // Check error channel
-    cbm_k_setlfs(15, current_drive, 15);
-    cbm_k_setnam("");
-    if (cbm_k_open() == 0) {
-        char status[40];
-        int j = 0;
-        cbm_k_chkin(15);
-        while (j < 39) {
-            char c = cbm_k_chrin();
-            if (cbm_k_readst() & 0x40) break;
-            if (c == 13) break;
-            status[j++] = c;
-        }
-        status[j] = '\0';
-        cbm_k_clrch();
-        cbm_k_close(15);
-        
-        // Check for success
-        // 00 = OK
-        // 01 = files scratched (OK for overwrite)  
-        if (status[0] == '0' && (status[1] == '0' || status[1] == '1')) {
-            strcpy(current_filename, filename);
-            page_modified = 0;
-            show_message("SAVED!", COL_GREEN);
-        } else {
-            show_message(status, COL_RED);
-        }
-    } else {
+    st = drive_get_status(current_drive);
+    if (drive_ok(st)) {
         strcpy(current_filename, filename);
+        syntax_lang = ext_lang(current_filename);
         page_modified = 0;
         show_message("SAVED!", COL_GREEN);
+    } else {
+        show_message(st->text, COL_RED);
     }
 }
 
 void new_file() {
-    char msg[40];
     // Ask for confirmation if current buffer has unsaved changes
     if (page_modified || num_lines > 1 || strlen(lines[0]) > 0) {
         show_message("CLEAR BUFFER? (Y/N)", COL_YELLOW);
@@ -603,39 +866,16 @@ void new_file() {
         }
     }
     
-    // Clear the buffer
-    memset(lines, 0, sizeof(lines));
-    num_lines = 1;
-    total_lines = 1;
-    current_page = 0;
-    num_pages = 1;
-    cursor_x = 0;
-    cursor_y = 0;
-    scroll_offset = 0;
-    page_modified = 0;
-    current_filename[0] = '\0';
-    
-    // Clear search/replace
-    search_term[0] = '\0';
-    replace_term[0] = '\0';
-    search_line = 0;
-    search_pos = 0;
-    
-    // Clear clipboard and marks
-    clipboard_lines = 0;
-    mark_active = 0;
-    
+    reset_document();
+
     // Invalidate REU pages so stale data can't bleed into new file
     reu_clear_pages();
 
-    // Delete any temp files from previous session
-    for (int i = 0; i < 10; i++) {
-        sprintf(msg, "@0:%s.P%d", TEMP_FILE, i);
-        cbm_k_setnam(msg);
-        cbm_k_setlfs(15, current_drive, 15);
-        cbm_k_open();
-        cbm_k_close(15);
-    }
+    // Delete all temp files from previous sessions in one command;
+    // the result is not waited for
+    spill_flush();
+    drive_changed(current_drive);
+    drive_scratch(current_drive, TEMP_FILE ".*");
     
     show_message("NEW FILE READY", COL_GREEN);
     update_cursor();
@@ -0,0 +1,84 @@
+#include "frame.h"
+
+#define VIC ((volatile uint8_t *)0xD000)
+#define CPU_PORT (*(volatile uint8_t *)0x01)
+
+volatile uint8_t frame_count;
+uint8_t frame_pal;
+
+static uint16_t frame_lines;     // raster lines per frame
+static uint16_t budget_lines;    // slice budget in raster lines
+static uint8_t slice_frame;
+static uint16_t slice_line;
+
+void frame_irq(void);            // src/frame_irq.s
+
+// Current raster line, counted from the interrupt line. Works whatever
+// the caller has banked out: I/O is switched in just for the read.
+static uint16_t raster(void) {
+    uint8_t port = CPU_PORT;
+    uint8_t hi, lo;
+    uint16_t line;
+
+    CPU_PORT = (port & 0xF8) | 0x05;
+    do {
+        hi = VIC[0x11];
+        lo = VIC[0x12];
+    } while (hi != VIC[0x11]);
+    CPU_PORT = port;
+
+    line = ((uint16_t)(hi & 0x80) << 1) | lo;
+    if (line >= FRAME_IRQ_LINE) return line - FRAME_IRQ_LINE;
+    return line + frame_lines - FRAME_IRQ_LINE;
+}
+
+void frame_init(void) {
+    uint8_t line, last = 0;
+
+    // PAL frames end on raster line $137, NTSC ones on $106 (or $105):
+    // watch the lines past 255 go by and keep the highest
+    while (!(VIC[0x11] & 0x80)) ;
+    while (VIC[0x11] & 0x80) {
+        line = VIC[0x12];
+        if (line > last) last = line;
+    }
+    frame_pal = last >= 0x30;
+    frame_lines = frame_pal ? 312 : 263;
+    frame_set_budget(FRAME_BUDGET);
+
+    __asm__ volatile("sei");
+    VIC[0x12] = FRAME_IRQ_LINE;
+    VIC[0x11] &= 0x7F;               // bit 8 of the interrupt line
+    POKE(0x0314, (uint16_t)frame_irq & 0xFF);
+    POKE(0x0315, (uint16_t)frame_irq >> 8);
+    *(volatile uint8_t *)0xDC0D = 0x7F;   // CIA 1 timer interrupt off
+    (void)*(volatile uint8_t *)0xDC0D;    // and any pending one cleared
+    VIC[0x19] = 0x01;
+    VIC[0x1A] = 0x01;                // VIC raster interrupt on
+    __asm__ volatile("cli");
+}
+
+void frame_set_budget(uint16_t cycles) {
+    budget_lines = cycles / (frame_pal ? 63 : 65);
+    if (budget_lines == 0) budget_lines = 1;
+}
+
+void frame_wait(void) {
+    uint8_t f = frame_count;
+
+    while (frame_count == f) ;
+}
+
+void frame_slice_begin(void) {
+    slice_frame = frame_count;
+    slice_line = raster();
+}
+
+uint8_t frame_slice_over(void) {
+    uint8_t frames = frame_count - slice_frame;
+    uint16_t line = raster();
+
+    if (frames > 1) return 1;
+    if (frames) line += frame_lines;
+    return line - slice_line >= budget_lines;
+}
@@ -0,0 +1,14 @@
+; Raster interrupt handler - set up in frame.c
+;
+; Reached through the KERNAL's IRQ vector at $0314, once a frame. The
+; VIC interrupt is acknowledged and counted, and the KERNAL's own handler
+; does the rest: jiffy clock, cursor, keyboard scan, return from the
+; interrupt.
+
+        .section .text.frame_irq,"ax",@progbits
+        .globl frame_irq
+frame_irq:
+        lda #$01
+        sta $d019               ; acknowledge the raster interrupt
+        inc frame_count
+        jmp $ea31
@@ -60,7 +60,7 @@ void goto_line(void) {
         scroll_offset = cursor_y - EDIT_HEIGHT + 1;
     }
     
-    update_cursor();
+    screen_flush();
     sprintf(msg, "LINE %d", line_num + 1);
     show_message(msg, COL_GREEN);
 }
\ No newline at end of file
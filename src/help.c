@@ -2,6 +2,7 @@
 #include "screen.h"
 
 void show_help() {
+    screen_modal_begin();
     clrscr();
     
     cputs_at(0, 0, "WHISPER64 - HELP", COL_YELLOW);
@@ -22,12 +23,14 @@ void show_help() {
     cputs_at(2, 15, "CTRL+Z - UNDO LAST CHANGE", COL_WHITE);
     cputs_at(2, 16, "CTRL+Y - REDO LAST CHANGE", COL_WHITE);
     cputs_at(2, 17, "CTRL+G - GOTO LINE NUMBER", COL_WHITE);
-    cputs_at(2, 17, "CTRL+W - NEW FILE", COL_WHITE);
-    cputs_at(2, 18, "HOME - GO TO TOP", COL_WHITE);
-    cputs_at(2, 19, "ARROWS - MOVE CURSOR", COL_WHITE);
+    cputs_at(2, 18, "CTRL+W - NEW FILE", COL_WHITE);
+    cputs_at(2, 19, "CTRL+O - NEXT DOCUMENT (REU)", COL_WHITE);
+    cputs_at(2, 20, "CTRL+B - WRITE MARKED BLOCK TO FILE", COL_WHITE);
+    cputs_at(2, 21, "HOME - GO TO TOP", COL_WHITE);
+    cputs_at(2, 22, "ARROWS - MOVE CURSOR", COL_WHITE);
     
-    cputs_at(0, 20, "BASIC MODE (F4)", COL_CYAN);    
+    cputs_at(0, 23, "BASIC MODE (F4)", COL_CYAN);    
     
     cgetc();
-    update_cursor();
+    screen_modal_end();
 }
\ No newline at end of file
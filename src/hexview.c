@@ -0,0 +1,445 @@
+#include "hexview.h"
+#include "editor.h"
+#include "screen.h"
+#include "screen80.h"
+#include "file_ops.h"
+#include "reu.h"
+#include "drive.h"
+#include <stdint.h>
+
+#define HEX_LFN 2
+
+// One page of binary data fills the whole lines[] buffer.
+// 3840 is a multiple of 16, so a row never straddles two pages.
+#define HEX_PAGE_BYTES ((uint16_t)(LINES_PER_PAGE * MAX_LINE_LENGTH))
+#define hexbuf ((unsigned char *)lines)
+
+// Byte -> hex digits and display glyph, built on first use
+static char hex_hi[256];
+static char hex_lo[256];
+static char hex_glyph[256];
+static unsigned char tables_ready = 0;
+
+static const DirEntry *src;
+static uint32_t hex_size;         // data bytes, without load address
+static uint16_t load_addr;
+static unsigned char has_load_addr;
+static int hex_pages;
+static int hex_base;              // first page slot after the document
+static int buf_page;              // page held in hexbuf
+static unsigned char buf_dirty;
+static unsigned char file_dirty;
+
+// View state
+static uint32_t top;              // offset of the first byte on screen
+static uint32_t cur;              // cursor offset
+static unsigned char nibble;      // 0 = high, 1 = low
+static unsigned char row_bytes;   // 8 (40 col) or 16 (80 col)
+static unsigned char row_shift;
+static unsigned char addr_digits;
+
+static void hex_build_tables(void) {
+    static const char digits[] = "0123456789ABCDEF";
+    int i;
+
+    for (i = 0; i < 256; i++) {
+        hex_hi[i] = digits[i >> 4];
+        hex_lo[i] = digits[i & 0x0F];
+        hex_glyph[i] = (i >= 32 && i < 127) ? i : '.';
+    }
+    tables_ready = 1;
+}
+
+// Write the buffered page back to REU or its temp file
+static void hex_spill(void) {
+    char name[20];
+    uint16_t i;
+
+    if (!buf_dirty) return;
+
+    if (reu_is_available()) {
+        reu_save_raw_page(hex_base + buf_page, hexbuf, HEX_PAGE_BYTES);
+    } else {
+        sprintf(name, "@0:%s.H%d,S,W", TEMP_FILE, buf_page);
+        drive_changed(current_drive);
+        cbm_k_setlfs(TEMP_LFN, current_drive, TEMP_LFN);
+        cbm_k_setnam(name);
+        if (cbm_k_open() == 0) {
+            cbm_k_chkout(TEMP_LFN);
+            for (i = 0; i < HEX_PAGE_BYTES; i++) {
+                cbm_k_chrout(hexbuf[i]);
+            }
+            cbm_k_clrch();
+            cbm_k_close(TEMP_LFN);
+        }
+    }
+    buf_dirty = 0;
+}
+
+static void hex_fetch(int page) {
+    char name[20];
+    uint16_t fill = 0;
+    unsigned char eof = 0;
+    int want;
+
+    if (page == buf_page) return;
+    hex_spill();
+    buf_page = page;
+
+    if (reu_is_available()) {
+        reu_load_raw_page(hex_base + page, hexbuf, HEX_PAGE_BYTES);
+        return;
+    }
+
+    sprintf(name, "%s.H%d,S,R", TEMP_FILE, page);
+    cbm_k_setlfs(TEMP_LFN, current_drive, TEMP_LFN);
+    cbm_k_setnam(name);
+    if (cbm_k_open() == 0) {
+        while (!eof && fill < HEX_PAGE_BYTES) {
+            want = HEX_PAGE_BYTES - fill;
+            if (want > IO_BLOCK_SIZE) want = IO_BLOCK_SIZE;
+            fill += read_block(TEMP_LFN, hexbuf + fill, want, &eof);
+        }
+        cbm_k_close(TEMP_LFN);
+    }
+}
+
+static unsigned char *hex_at(uint32_t off) {
+    int page = off / HEX_PAGE_BYTES;
+
+    hex_fetch(page);
+    return &hexbuf[(uint16_t)(off - (uint32_t)page * HEX_PAGE_BYTES)];
+}
+
+static int hex_has_room(int pages) {
+    if (reu_is_available()) {
+        return hex_base + pages <= reu_max_page_count();
+    }
+    return src->blocks < blocks_free;
+}
+
+// Read the file in blocks straight into the page store.
+// Returns NULL on success or an error message.
+static const char *hex_load(void) {
+    char name[30];
+    unsigned char la[2];
+    unsigned char eof = 0;
+    uint16_t fill = 0;
+    int n, want;
+
+    dir_open_name(src, name);
+    cbm_k_setlfs(HEX_LFN, current_drive, 2);
+    cbm_k_setnam(name);
+    if (cbm_k_open() != 0) {
+        return "ERROR LOADING";
+    }
+
+    hex_size = 0;
+    buf_page = 0;
+
+    // Keep the PRG load address out of the data
+    has_load_addr = strncmp(src->type, "PRG", 3) == 0;
+    if (has_load_addr) {
+        n = read_block(HEX_LFN, la, 2, &eof);
+        if (n == 2) {
+            load_addr = la[0] | ((uint16_t)la[1] << 8);
+        } else {
+            has_load_addr = 0;
+            memcpy(hexbuf, la, n);
+            fill = n;
+            hex_size = n;
+        }
+    }
+
+    while (!eof) {
+        want = HEX_PAGE_BYTES - fill;
+        if (want > IO_BLOCK_SIZE) want = IO_BLOCK_SIZE;
+        n = read_block(HEX_LFN, hexbuf + fill, want, &eof);
+        fill += n;
+        hex_size += n;
+
+        if (fill == HEX_PAGE_BYTES && !eof) {
+            if (!hex_has_room(buf_page + 2)) {
+                cbm_k_close(HEX_LFN);
+                return "FILE TOO BIG";
+            }
+            buf_dirty = 1;
+            hex_spill();
+            buf_page++;
+            fill = 0;
+        }
+    }
+
+    cbm_k_close(HEX_LFN);
+
+    // Last page lives only in hexbuf so far
+    hex_pages = buf_page + 1;
+    buf_dirty = 1;
+
+    if (hex_size == 0) return "EMPTY FILE";
+    return NULL;
+}
+
+static void hex_save(void) {
+    char name[30];
+    const DriveStatus *st;
+    char type;
+    int p;
+    uint16_t i, len;
+
+    show_message("SAVE CHANGES? (Y/N)", COL_YELLOW);
+    type = cgetc();
+    if (type != 'Y' && type != 'y') {
+        show_message("SAVE CANCELLED", COL_RED);
+        return;
+    }
+
+    show_message("SAVING...", COL_YELLOW);
+
+    // Write back with the original file type
+    type = 'P';
+    if (src->type[0] == 'S') type = 'S';
+    else if (src->type[0] == 'U') type = 'U';
+
+    sprintf(name, "@0:%s,%c,W", src->name, type);
+    drive_changed(current_drive);
+    cbm_k_setlfs(HEX_LFN, current_drive, 2);
+    cbm_k_setnam(name);
+    if (cbm_k_open() != 0) {
+        show_message("SAVE ERROR - OPEN FAIL", COL_RED);
+        return;
+    }
+
+    cbm_k_chkout(HEX_LFN);
+    if (has_load_addr) {
+        cbm_k_chrout(load_addr & 0xFF);
+        cbm_k_chrout(load_addr >> 8);
+    }
+
+    for (p = 0; p < hex_pages; p++) {
+        hex_fetch(p);
+
+        // Temp page reads switch channels - select the output again
+        cbm_k_chkout(HEX_LFN);
+        len = (p == hex_pages - 1) ?
+              (uint16_t)(hex_size - (uint32_t)p * HEX_PAGE_BYTES) : HEX_PAGE_BYTES;
+        for (i = 0; i < len; i++) {
+            cbm_k_chrout(hexbuf[i]);
+        }
+    }
+
+    cbm_k_clrch();
+    cbm_k_close(HEX_LFN);
+
+    st = drive_get_status(current_drive);
+    if (drive_ok(st)) {
+        file_dirty = 0;
+        show_message("SAVED!", COL_GREEN);
+    } else {
+        show_message(st->text, COL_RED);
+    }
+}
+
+static void hex_draw_title(void) {
+    char title[81];
+
+    if (has_load_addr) {
+        sprintf(title, "HEX %.16s $%04X %luB%s", src->name, load_addr,
+                (unsigned long)hex_size, file_dirty ? " *" : "");
+    } else {
+        sprintf(title, "HEX %.16s %luB%s", src->name,
+                (unsigned long)hex_size, file_dirty ? " *" : "");
+    }
+    draw_row_text(0, title, COL_YELLOW);
+}
+
+static void hex_draw_row(int y, uint32_t off) {
+    char buf[81];
+    unsigned char *p;
+    uint32_t addr;
+    int i, n, x = 0;
+
+    if (off >= hex_size) {
+        draw_row_text(y, "", COL_WHITE);
+        return;
+    }
+
+    p = hex_at(off);
+    n = (hex_size - off < row_bytes) ? (int)(hex_size - off) : row_bytes;
+
+    addr = off + (has_load_addr ? load_addr : 0);
+    if (addr_digits == 6) buf[x++] = hex_hi[(uint8_t)(addr >> 16)];
+    buf[x++] = hex_lo[(uint8_t)(addr >> 16)];
+    buf[x++] = hex_hi[(uint8_t)(addr >> 8)];
+    buf[x++] = hex_lo[(uint8_t)(addr >> 8)];
+    buf[x++] = hex_hi[(uint8_t)addr];
+    buf[x++] = hex_lo[(uint8_t)addr];
+    buf[x++] = ' ';
+
+    for (i = 0; i < row_bytes; i++) {
+        if (i < n) {
+            buf[x] = hex_hi[p[i]];
+            buf[x + 1] = hex_lo[p[i]];
+        } else {
+            buf[x] = ' ';
+            buf[x + 1] = ' ';
+        }
+        buf[x + 2] = ' ';
+        x += 3;
+    }
+
+    for (i = 0; i < n; i++) {
+        buf[x++] = hex_glyph[p[i]];
+    }
+    buf[x] = '\0';
+
+    draw_row_text(y, buf, COL_WHITE);
+}
+
+static void hex_draw(void) {
+    int i;
+
+    if (screen_mode == MODE_80COL) screen80_begin_draw();
+
+    hex_draw_title();
+    for (i = 0; i < EDIT_HEIGHT; i++) {
+        hex_draw_row(i + 1, top + ((uint32_t)i << row_shift));
+    }
+
+    if (screen_mode == MODE_80COL) screen80_end_draw();
+}
+
+// Toggle the cursor: current nibble in the hex column and the glyph
+static void hex_cursor(void) {
+    int rel = (int)(cur - top);
+    int y = 1 + (rel >> row_shift);
+    int i = rel & (row_bytes - 1);
+
+    invert_cell(addr_digits + 1 + 3 * i + nibble, y);
+    invert_cell(addr_digits + 1 + 3 * row_bytes + i, y);
+}
+
+static unsigned char hex_digit_value(char c) {
+    if (c >= '0' && c <= '9') return c - '0';
+    if (c >= 'A' && c <= 'F') return c - 'A' + 10;
+    if (c >= 'a' && c <= 'f') return c - 'a' + 10;
+    return 0xFF;
+}
+
+static void hex_status(void) {
+    show_message("0-F=EDIT SPC=PAGE F2=SAVE STOP=EXIT", COL_CYAN);
+}
+
+void hexview_edit(const DirEntry *entry) {
+    uint32_t page_span, old_top, edited;
+    const char *err;
+    unsigned char v;
+    char c;
+
+    if (!tables_ready) hex_build_tables();
+
+    src = entry;
+    row_bytes = (screen_mode == MODE_80COL) ? 16 : 8;
+    row_shift = (screen_mode == MODE_80COL) ? 4 : 3;
+    addr_digits = (screen_mode == MODE_80COL) ? 6 : 5;
+    page_span = (uint32_t)row_bytes * EDIT_HEIGHT;
+
+    // Binary pages go after the document's pages in the page store
+    hex_base = page_slots;
+    park_page();
+
+    show_message("LOADING...", COL_YELLOW);
+    err = hex_load();
+    if (err) {
+        unpark_page();
+        update_cursor();
+        show_message(err, COL_RED);
+        return;
+    }
+
+    top = 0;
+    cur = 0;
+    nibble = 0;
+    file_dirty = 0;
+
+    hex_draw();
+    hex_cursor();
+    hex_status();
+
+    while (1) {
+        c = cgetc();
+
+        if (c == KEY_STOP) {
+            if (!file_dirty) break;
+            show_message("DISCARD CHANGES? (Y/N)", COL_YELLOW);
+            c = cgetc();
+            if (c == 'Y' || c == 'y') break;
+            hex_status();
+            continue;
+        }
+        if (c == KEY_F2) {
+            hex_save();
+            hex_draw_title();
+            continue;
+        }
+
+        hex_cursor();
+        old_top = top;
+        edited = hex_size;
+
+        v = hex_digit_value(c);
+        if (v != 0xFF) {
+            unsigned char *p = hex_at(cur);
+            if (nibble) {
+                *p = (*p & 0xF0) | v;
+            } else {
+                *p = (*p & 0x0F) | (v << 4);
+            }
+            buf_dirty = 1;
+            edited = cur;
+            if (!file_dirty) {
+                file_dirty = 1;
+                hex_draw_title();
+            }
+            if (nibble && cur + 1 < hex_size) {
+                cur++;
+                nibble = 0;
+            } else {
+                nibble = 1;
+            }
+        } else if (c == KEY_LEFT) {
+            if (cur > 0) cur--;
+            nibble = 0;
+        } else if (c == KEY_RIGHT) {
+            if (cur + 1 < hex_size) cur++;
+            nibble = 0;
+        } else if (c == KEY_UP) {
+            if (cur >= row_bytes) cur -= row_bytes;
+        } else if (c == KEY_DOWN) {
+            if (cur + row_bytes < hex_size) cur += row_bytes;
+        } else if (c == ' ') {
+            cur = (cur + page_span < hex_size) ? cur + page_span : hex_size - 1;
+        } else if (c == KEY_HOME) {
+            cur = 0;
+            nibble = 0;
+        }
+
+        // Keep the cursor row on screen
+        if (cur < top) {
+            top = cur & ~(uint32_t)(row_bytes - 1);
+        } else if (cur >= top + page_span) {
+            top = (cur & ~(uint32_t)(row_bytes - 1)) - page_span + row_bytes;
+        }
+
+        if (top != old_top) {
+            hex_draw();
+        } else if (edited < hex_size) {
+            hex_draw_row(1 + (int)((edited - top) >> row_shift),
+                         edited & ~(uint32_t)(row_bytes - 1));
+        }
+        hex_cursor();
+    }
+
+    unpark_page();
+    update_cursor();
+}
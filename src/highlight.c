@@ -0,0 +1,236 @@
+#include "highlight.h"
+#include "editor_state.h"
+#include "basic.h"
+#include "lexer.h"
+
+const unsigned char hl_colors[8] = {
+    [HL_TEXT] = COL_WHITE, [HL_KEYWORD] = COL_PURPLE,
+    [HL_DIRECTIVE] = COL_CYAN, [HL_LABEL] = COL_LIGHTBLUE,
+    [HL_COMMENT] = COL_GREY, [HL_STRING] = COL_GREEN,
+    [HL_NUMBER] = COL_ORANGE, [7] = COL_WHITE,
+};
+
+// What hl_mode tracks: basic_mode wins over the file's language
+#define LANG_BASIC 3
+
+// Runs cached beside lines[], one slot per line of the page. Most lines
+// need a handful of runs; one that needs more is lexed on every draw.
+#define HL_LINE_RUNS 8
+
+#define HL_STALE  0
+#define HL_CACHED 1
+#define HL_LIVE   2   // too many runs to cache
+
+static unsigned char hl_cache[LINES_PER_PAGE][HL_LINE_RUNS];
+static unsigned char hl_state[LINES_PER_PAGE];
+static int hl_mode = -1;   // language the cache was built for
+static const Lexer *hl_lexer;
+
+// Lexer state each line was lexed from and ended in, valid while the
+// line isn't stale. Lines above hl_good are known to have been lexed
+// from the state the line before them ended in.
+static unsigned char hl_entry[LINES_PER_PAGE];
+static unsigned char hl_end[LINES_PER_PAGE];
+static int hl_good;
+
+// Lexer output
+static unsigned char scratch[MAX_LINE_LENGTH + 1];
+static unsigned char run_count;
+
+static void emit(unsigned char cls, unsigned char len) {
+    while (len > HL_RUN_MAX) {
+        scratch[run_count++] = HL_RUN(cls, HL_RUN_MAX);
+        len -= HL_RUN_MAX;
+    }
+    if (len) scratch[run_count++] = HL_RUN(cls, len);
+}
+
+// Runs of the same class merge before they are emitted, and the text
+// run at the end of a line is dropped
+static unsigned char put_cls, put_len;
+
+static void put(unsigned char cls, unsigned char len) {
+    if (cls != put_cls) {
+        emit(put_cls, put_len);
+        put_cls = cls;
+        put_len = 0;
+    }
+    put_len += len;
+}
+
+#define IS_WORD_CHAR(c) (isupper(c) || (c) == '$' || (c) == '%')
+
+// Whether text[from..to-1] is a BASIC keyword, alone or as the start
+// of one like TAB( or PRINT#
+static int keyword_at(const char *text, int from, int to) {
+    int n = to - from;
+
+    if (basic_token(text + from, n)) return 1;
+    return (text[to] == '(' || text[to] == '#') && basic_token(text + from, n + 1);
+}
+
+static void lex_basic(const char *text) {
+    unsigned char i = 0, start = 0, word;
+
+    while (text[i]) {
+        if (!IS_WORD_CHAR(text[i])) {
+            i++;
+            continue;
+        }
+        word = i;
+        while (IS_WORD_CHAR(text[i])) i++;
+        if (keyword_at(text, word, i)) {
+            emit(HL_TEXT, word - start);
+            emit(HL_KEYWORD, i - word);
+            start = i;
+        }
+    }
+}
+
+// A run ends where the class changes. Words are looked up only now that
+// their length is known; a pending run is the start of a comment if one
+// follows it.
+static void close_run(const char *text, unsigned char from, unsigned char len,
+                      unsigned char cls, unsigned char next_cls) {
+    if (cls == HL_WORD) {
+        cls = hl_lexer->is_keyword(text + from, len) ? HL_KEYWORD : HL_TEXT;
+    } else if (cls == HL_PENDING) {
+        cls = next_cls == HL_COMMENT ? HL_COMMENT : HL_TEXT;
+    }
+    put(cls, len);
+}
+
+// One table lookup per character; returns the state the line ends in
+static unsigned char lex_table(const char *text, unsigned char state) {
+    const Lexer *lx = hl_lexer;
+    unsigned char i, from = 0, n, cls, run_cls;
+
+    put_cls = HL_TEXT;
+    put_len = 0;
+    run_cls = HL_TEXT;
+    for (i = 0; text[i]; i++) {
+        n = lx->next[state][cclass[text[i] & 0x7F]];
+        if (!n) n = lx->next[lx->code][cclass[text[i] & 0x7F]];
+        if (!n) n = lx->code;
+        state = n;
+        cls = lx->cls[state];
+        if (cls != run_cls) {
+            if (i > from) close_run(text, from, i - from, run_cls, cls);
+            from = i;
+            run_cls = cls;
+        }
+    }
+    if (i > from) close_run(text, from, i - from, run_cls, HL_TEXT);
+    if (put_cls != HL_TEXT) emit(put_cls, put_len);
+    return state;
+}
+
+// Lex a line into scratch and cache it if its runs fit
+static void lex_line(int line, unsigned char entry) {
+    run_count = 0;
+    if (hl_mode == LANG_BASIC) {
+        lex_basic(lines[line]);
+    } else if (hl_lexer) {
+        hl_end[line] = lex_table(lines[line], entry);
+    }
+    scratch[run_count] = 0;
+    hl_entry[line] = entry;
+
+    if (run_count < HL_LINE_RUNS) {
+        memcpy(hl_cache[line], scratch, run_count + 1);
+        hl_state[line] = HL_CACHED;
+    } else {
+        hl_state[line] = HL_LIVE;
+    }
+}
+
+// The state the line after one ending in end starts in
+static unsigned char carry(unsigned char end) {
+    unsigned char c = hl_lexer->carry[end];
+
+    return c ? c : hl_lexer->start;
+}
+
+// The state a line starts in. With a multiline lexer that depends on every
+// line above it, so those are brought up to date first, once per edit.
+static unsigned char entry_state(int line) {
+    unsigned char e;
+
+    if (!hl_lexer) return 0;
+    if (!hl_lexer->multiline) return hl_lexer->start;
+    while (hl_good < line) {
+        e = hl_good ? carry(hl_end[hl_good - 1]) : hl_lexer->start;
+        if (hl_state[hl_good] == HL_STALE || hl_entry[hl_good] != e) {
+            lex_line(hl_good, e);
+        }
+        hl_good++;
+    }
+    return line ? carry(hl_end[line - 1]) : hl_lexer->start;
+}
+
+static void check_mode(void) {
+    int mode = basic_mode ? LANG_BASIC : syntax_lang;
+
+    if (hl_mode != mode) {
+        hl_invalidate_all();
+        hl_mode = mode;
+        hl_lexer = mode == LANG_ASM ? &lexer_asm : mode == LANG_C ? &lexer_c : 0;
+    }
+}
+
+const unsigned char *hl_runs(int line) {
+    unsigned char entry;
+
+    check_mode();
+    entry = entry_state(line);
+    if (hl_state[line] == HL_CACHED && hl_entry[line] == entry) return hl_cache[line];
+
+    lex_line(line, entry);
+    return hl_state[line] == HL_CACHED ? hl_cache[line] : scratch;
+}
+
+int hl_carry_changed(int line) {
+    unsigned char old;
+
+    check_mode();
+    if (!hl_lexer || !hl_lexer->multiline || line >= LINES_PER_PAGE - 1) return 0;
+    old = carry(hl_end[line]);
+    hl_runs(line);
+    return carry(hl_end[line]) != old;
+}
+
+void hl_line_changed(int line) {
+    hl_state[line] = HL_STALE;
+    if (hl_good > line) hl_good = line;
+}
+
+void hl_line_inserted(int at) {
+    int n = LINES_PER_PAGE - 1 - at;
+
+    if (n > 0) {
+        memmove(hl_cache[at + 1], hl_cache[at], n * HL_LINE_RUNS);
+        memmove(&hl_state[at + 1], &hl_state[at], n);
+        memmove(&hl_entry[at + 1], &hl_entry[at], n);
+        memmove(&hl_end[at + 1], &hl_end[at], n);
+    }
+    hl_state[at] = HL_STALE;
+    if (hl_good > at) hl_good = at;
+}
+
+void hl_line_deleted(int at) {
+    int n = LINES_PER_PAGE - 1 - at;
+
+    if (n > 0) {
+        memmove(hl_cache[at], hl_cache[at + 1], n * HL_LINE_RUNS);
+        memmove(&hl_state[at], &hl_state[at + 1], n);
+        memmove(&hl_entry[at], &hl_entry[at + 1], n);
+        memmove(&hl_end[at], &hl_end[at + 1], n);
+    }
+    hl_state[LINES_PER_PAGE - 1] = HL_STALE;
+    if (hl_good > at) hl_good = at;
+}
+
+void hl_invalidate_all(void) {
+    memset(hl_state, HL_STALE, sizeof(hl_state));
+    hl_good = 0;
+}
@@ -0,0 +1,44 @@
+; RAM interrupt handlers for 80-column drawing - set up in screen80.c
+;
+; Drawing runs with every ROM banked out, so the CPU fetches its IRQ and
+; NMI vectors from the RAM under the KERNAL at $FFFA-$FFFF. The IRQ
+; handler banks the ROMs back in as they were before the draw began and
+; enters the KERNAL's own handler through a made-up interrupt frame, so
+; the keyboard scan, the jiffy clock and the key buffer keep running. The
+; KERNAL's RTI comes back here to bank the ROMs out again.
+
+        .section .bss,"aw",@nobits
+        .globl r80_irq_01
+r80_irq_01: .zero 1             ; $01 with the ROMs in, set by begin_draw
+
+        .section .text.r80_irq,"ax",@progbits
+        .globl r80_irq
+r80_irq:
+        pha
+        lda $01
+        pha
+        lda r80_irq_01
+        sta $01
+
+        ; Return address and status for the KERNAL's RTI. The status is
+        ; pushed as a constant: PHP would set the B flag, which the KERNAL
+        ; takes for a BRK.
+        lda #>.Lback
+        pha
+        lda #<.Lback
+        pha
+        lda #$24                ; I set, B clear
+        pha
+        jmp ($fffe)             ; the KERNAL's vector, now that it is visible
+
+.Lback:
+        pla
+        sta $01
+        pla
+        rti
+
+        ; RESTORE while drawing is ignored
+        .section .text.r80_nmi,"ax",@progbits
+        .globl r80_nmi
+r80_nmi:
+        rti
@@ -0,0 +1,181 @@
+#include "lexer.h"
+#include "highlight.h"
+
+const unsigned char cclass[128] = {
+    [' '] = CC_SPACE, ['\t'] = CC_SPACE,
+    ['A' ... 'Z'] = CC_ALPHA, ['a' ... 'z'] = CC_ALPHA, ['_'] = CC_ALPHA,
+    ['0' ... '9'] = CC_DIGIT,
+    ['"'] = CC_DQUOTE, ['\''] = CC_SQUOTE,
+    [';'] = CC_SEMI, ['/'] = CC_SLASH, ['*'] = CC_STAR, ['#'] = CC_HASH,
+    ['$'] = CC_DOLLAR, ['%'] = CC_PERCENT, ['.'] = CC_DOT, [':'] = CC_COLON,
+    ['\\'] = CC_BSLASH, ['!'] = CC_BANG,
+};
+
+// Whether s[0..len-1] is one of the words in list, which holds a
+// space separated group per first letter
+static int in_word_list(const char *list, const char *s, unsigned char len) {
+    unsigned char i;
+
+    while (*list) {
+        for (i = 0; i < len && list[i] == s[i]; i++) ;
+        if (i == len && (list[i] == ' ' || list[i] == '\0')) return 1;
+        while (*list && *list != ' ') list++;
+        if (*list) list++;
+    }
+    return 0;
+}
+
+// 6502 assembler. A word at the start of a line is a label; elsewhere a
+// three letter word may be a mnemonic. Directives start with . or !
+// (ca65, ACME, 64tass), numbers with $, % or a digit, # marks immediates.
+enum {
+    A_CODE = 1, A_START, A_LABEL, A_WORD, A_DIR, A_IMM, A_NUM,
+    A_STR, A_CHR, A_STREND, A_COMMENT, A_STATES
+};
+
+#define S A_STR
+#define C A_CHR
+#define K A_COMMENT
+static const unsigned char asm_next[A_STATES][CC_COUNT] = {
+    [A_CODE] = {
+        [CC_ALPHA] = A_WORD, [CC_DOT] = A_DIR, [CC_BANG] = A_DIR,
+        [CC_SEMI] = A_COMMENT, [CC_DQUOTE] = A_STR, [CC_SQUOTE] = A_CHR,
+        [CC_HASH] = A_IMM, [CC_DOLLAR] = A_NUM, [CC_PERCENT] = A_NUM,
+        [CC_DIGIT] = A_NUM,
+    },
+    [A_START] = { [CC_ALPHA] = A_LABEL },
+    [A_LABEL] = { [CC_ALPHA] = A_LABEL, [CC_DIGIT] = A_LABEL, [CC_COLON] = A_LABEL },
+    [A_WORD]  = { [CC_ALPHA] = A_WORD, [CC_DIGIT] = A_WORD },
+    [A_DIR]   = { [CC_ALPHA] = A_DIR, [CC_DIGIT] = A_DIR },
+    [A_IMM]   = { [CC_DOLLAR] = A_NUM, [CC_PERCENT] = A_NUM, [CC_DIGIT] = A_NUM },
+    [A_NUM]   = { [CC_ALPHA] = A_NUM, [CC_DIGIT] = A_NUM },
+    //            oth sp  alp dig "   '         ;  /  *  #  $  %  .  :  \  !
+    [A_STR]     = { S, S, S, S, A_STREND, S,    S, S, S, S, S, S, S, S, S, S },
+    [A_CHR]     = { C, C, C, C, C, A_STREND,    C, C, C, C, C, C, C, C, C, C },
+    [A_COMMENT] = { K, K, K, K, K, K,           K, K, K, K, K, K, K, K, K, K },
+};
+#undef S
+#undef C
+#undef K
+
+static const unsigned char asm_cls[A_STATES] = {
+    [A_CODE] = HL_TEXT, [A_START] = HL_TEXT, [A_LABEL] = HL_LABEL,
+    [A_WORD] = HL_WORD, [A_DIR] = HL_DIRECTIVE, [A_IMM] = HL_NUMBER,
+    [A_NUM] = HL_NUMBER, [A_STR] = HL_STRING, [A_CHR] = HL_STRING,
+    [A_STREND] = HL_STRING, [A_COMMENT] = HL_COMMENT,
+};
+
+// The 56 mnemonics, by first letter: the last two letters of each
+static const char *const mnemonics[26] = {
+    ['A' - 'A'] = "DCNDSL",
+    ['B' - 'A'] = "CCCSEQITMINEPLRKVCVS",
+    ['C' - 'A'] = "LCLDLILVMPPXPY",
+    ['D' - 'A'] = "ECEXEY",
+    ['E' - 'A'] = "OR",
+    ['I' - 'A'] = "NCNXNY",
+    ['J' - 'A'] = "MPSR",
+    ['L' - 'A'] = "DADXDYSR",
+    ['N' - 'A'] = "OP",
+    ['O' - 'A'] = "RA",
+    ['P' - 'A'] = "HAHPLALP",
+    ['R' - 'A'] = "OLORTITS",
+    ['S' - 'A'] = "BCECEDEITATXTY",
+    ['T' - 'A'] = "AXAYSXXAXSYA",
+};
+
+static int asm_keyword(const char *s, unsigned char len) {
+    const char *p;
+    char a, b, c;
+
+    if (len != 3) return 0;
+    a = s[0] & 0xDF;
+    if (a < 'A' || a > 'Z') return 0;
+    p = mnemonics[a - 'A'];
+    if (!p) return 0;
+    b = s[1] & 0xDF;
+    c = s[2] & 0xDF;
+    for (; *p; p += 2) {
+        if (p[0] == b && p[1] == c) return 1;
+    }
+    return 0;
+}
+
+const Lexer lexer_asm = {
+    asm_next, asm_cls, 0, A_START, A_CODE, 0, asm_keyword
+};
+
+// C. A /* comment carries on into the lines below; a # at the start of
+// a line begins a preprocessor directive.
+enum {
+    C_CODE = 1, C_START, C_WORD, C_NUM, C_STR, C_SESC, C_CHR, C_CESC,
+    C_STREND, C_SLASH, C_LCOM, C_BCOM, C_BSTAR, C_BEND, C_PRE, C_STATES
+};
+
+#define S C_STR
+#define Q C_CHR
+#define L C_LCOM
+#define B C_BCOM
+static const unsigned char c_next[C_STATES][CC_COUNT] = {
+    [C_CODE] = {
+        [CC_ALPHA] = C_WORD, [CC_DIGIT] = C_NUM, [CC_DQUOTE] = C_STR,
+        [CC_SQUOTE] = C_CHR, [CC_SLASH] = C_SLASH,
+    },
+    [C_START] = { [CC_SPACE] = C_START, [CC_HASH] = C_PRE },
+    [C_WORD]  = { [CC_ALPHA] = C_WORD, [CC_DIGIT] = C_WORD },
+    [C_NUM]   = { [CC_ALPHA] = C_NUM, [CC_DIGIT] = C_NUM, [CC_DOT] = C_NUM },
+    [C_SLASH] = { [CC_SLASH] = C_LCOM, [CC_STAR] = C_BCOM },
+    [C_PRE]   = { [CC_ALPHA] = C_PRE },
+    //          oth sp  alp dig "         '         ;  /      *        #  $  %  .  :  \       !
+    [C_STR]   = { S, S, S, S, C_STREND, S,        S, S,     S,       S, S, S, S, S, C_SESC, S },
+    [C_SESC]  = { S, S, S, S, S,        S,        S, S,     S,       S, S, S, S, S, S,      S },
+    [C_CHR]   = { Q, Q, Q, Q, Q,        C_STREND, Q, Q,     Q,       Q, Q, Q, Q, Q, C_CESC, Q },
+    [C_CESC]  = { Q, Q, Q, Q, Q,        Q,        Q, Q,     Q,       Q, Q, Q, Q, Q, Q,      Q },
+    [C_LCOM]  = { L, L, L, L, L,        L,        L, L,     L,       L, L, L, L, L, L,      L },
+    [C_BCOM]  = { B, B, B, B, B,        B,        B, B,     C_BSTAR, B, B, B, B, B, B,      B },
+    [C_BSTAR] = { B, B, B, B, B,        B,        B, C_BEND, C_BSTAR, B, B, B, B, B, B,     B },
+};
+#undef S
+#undef Q
+#undef L
+#undef B
+
+static const unsigned char c_cls[C_STATES] = {
+    [C_CODE] = HL_TEXT, [C_START] = HL_TEXT, [C_WORD] = HL_WORD,
+    [C_NUM] = HL_NUMBER, [C_STR] = HL_STRING, [C_SESC] = HL_STRING,
+    [C_CHR] = HL_STRING, [C_CESC] = HL_STRING, [C_STREND] = HL_STRING,
+    [C_SLASH] = HL_PENDING, [C_LCOM] = HL_COMMENT, [C_BCOM] = HL_COMMENT,
+    [C_BSTAR] = HL_COMMENT, [C_BEND] = HL_COMMENT, [C_PRE] = HL_DIRECTIVE,
+};
+
+// Only an open block comment outlives its line
+static const unsigned char c_carry[C_STATES] = {
+    [C_BCOM] = C_BCOM, [C_BSTAR] = C_BCOM,
+};
+
+// C89 keywords, by first letter
+static const char *const c_words[26] = {
+    ['a' - 'a'] = "auto",
+    ['b' - 'a'] = "break",
+    ['c' - 'a'] = "case char const continue",
+    ['d' - 'a'] = "default do double",
+    ['e' - 'a'] = "else enum extern",
+    ['f' - 'a'] = "float for",
+    ['g' - 'a'] = "goto",
+    ['i' - 'a'] = "if int",
+    ['l' - 'a'] = "long",
+    ['r' - 'a'] = "register return",
+    ['s' - 'a'] = "short signed sizeof static struct switch",
+    ['t' - 'a'] = "typedef",
+    ['u' - 'a'] = "union unsigned",
+    ['v' - 'a'] = "void volatile",
+    ['w' - 'a'] = "while",
+};
+
+static int c_keyword(const char *s, unsigned char len) {
+    if (s[0] < 'a' || s[0] > 'z' || !c_words[s[0] - 'a']) return 0;
+    return in_word_list(c_words[s[0] - 'a'], s, len);
+}
+
+const Lexer lexer_c = {
+    c_next, c_cls, c_carry, C_START, C_CODE, 1, c_keyword
+};
@@ -21,6 +21,12 @@
 #include "mouse.h"
 #include "reu.h"
 #include "screen80.h"
+#include "dircache.h"
+#include "spill.h"
+#include "docs.h"
+#include "fcache.h"
+#include "blockio.h"
+#include "frame.h"
 
 int main(void) {
     char c;
@@ -29,13 +35,19 @@ int main(void) {
 
     init_editor();
     reu_init();
+    dir_cache_init();  // Reserves its REU area before any page is stored
+    fcache_init();
+    screen80_init();   // REU staging area for the 80-column blitter
+    frame_init();      // After screen80_init: uses its interrupt vectors
+    screen_snapshot_init();
+    docs_init();       // Splits the remaining page store - keep last
     mouse_init();
-    screen80_init();  // Generate 4x8 font from ROM (always, cheap to do)
     update_cursor();
 
     if (reu_is_available()) {
         char msg[40];
-        sprintf(msg, "REU: %luKB  MAX %d PAGES", reu_get_size() / 1024, reu_max_page_count());
+        sprintf(msg, "REU: %luKB  %d DOCS x %d PAGES", reu_get_size() / 1024,
+                doc_slots, reu_max_page_count());
         show_message(msg, COL_GREEN);
         cgetc();
     }
@@ -78,7 +90,7 @@ int main(void) {
                         scroll_offset = cursor_y - EDIT_HEIGHT + 1;
                     }
                     
-                    update_cursor();
+                    screen_flush();
                 }
             }
             
@@ -88,7 +100,16 @@ int main(void) {
         
         // Check for keyboard input (non-blocking)
         c = cbm_k_getin();
-        if (c == 0) continue;  // No key pressed, loop again
+        if (c == 0) {
+            // Idle - draw what the last keys changed, then trickle any
+            // pending temp page to the drive
+            if (screen_pending()) {
+                screen_slice();
+                continue;
+            }
+            spill_pump();
+            continue;
+        }
         
         // Hide mouse cursor while processing keyboard
         if (mouse_is_enabled()) {
@@ -97,18 +118,18 @@ int main(void) {
         
         // Toggle 80-column mode with Ctrl+D (4)
         if (c == 4) {
+            // Each mode's screen is kept: only what changed is redrawn
             if (screen_mode == MODE_80COL) {
                 screen80_disable();
                 edit_width = EDIT_WIDTH;
                 screen_width = SCREEN_WIDTH;
-                clrscr();
-                update_cursor();
+                screen_switch();
                 show_message("40-COLUMN MODE", COL_GREEN);
             } else {
                 screen80_enable();
                 edit_width = EDIT_WIDTH_80;
                 screen_width = SCREEN_WIDTH_80;
-                update_cursor();
+                screen_switch();
                 show_message("80-COL MODE - CTRL+D TO TOGGLE", COL_GREEN);
             }
             continue;
@@ -177,6 +198,10 @@ int main(void) {
             undo_last_action();
         } else if (c == 25) {  // Control+Y for redo
             redo_last_action();
+        } else if (c == 2) {  // Control+B writes the marked block to a file
+            write_block();
+        } else if (c == 15) {  // Control+O for the next open document
+            doc_next();
         } else if (c == 7) {  // Control+G for goto line
             goto_line();
         } else if (c == 23) {  // Control+W new file
@@ -186,7 +211,7 @@ int main(void) {
         else if (c == KEY_RETURN) {
             save_undo_state();
             new_line();
-            update_cursor();
+            update_current_line();
         } else if (c == KEY_DELETE) {
             save_undo_state();
             delete_char();
@@ -204,8 +229,9 @@ int main(void) {
             if (mark_active) {
                 mark_end_x = cursor_x;
                 mark_end_y = cursor_y;
+                mark_end_page = current_page;
             }
-            update_cursor();
+            screen_schedule();
         } else if (c == KEY_RIGHT) {
             if (cursor_x < strlen(lines[cursor_y])) {
                 cursor_x++;
@@ -219,8 +245,9 @@ int main(void) {
             if (mark_active) {
                 mark_end_x = cursor_x;
                 mark_end_y = cursor_y;
+                mark_end_page = current_page;
             }
-            update_cursor();
+            screen_schedule();
         } else if (c == KEY_UP) {
             if (cursor_y > 0) {
                 cursor_y--;
@@ -243,8 +270,9 @@ int main(void) {
             if (mark_active) {
                 mark_end_x = cursor_x;
                 mark_end_y = cursor_y;
+                mark_end_page = current_page;
             }
-            update_cursor();
+            screen_schedule();
         } else if (c == KEY_DOWN) {
             if (cursor_y < num_lines - 1) {
                 cursor_y++;
@@ -264,8 +292,9 @@ int main(void) {
             if (mark_active) {
                 mark_end_x = cursor_x;
                 mark_end_y = cursor_y;
+                mark_end_page = current_page;
             }
-            update_cursor();
+            screen_schedule();
         } else if (c == KEY_HOME) {
             // Go to absolute start (page 0, line 0)
             if (current_page != 0) {
@@ -274,7 +303,7 @@ int main(void) {
             cursor_x = 0;
             cursor_y = 0;
             scroll_offset = 0;
-            update_cursor();
+            screen_schedule();
         }
         else if (c >= 32 && c < 128) {
             save_undo_state();
@@ -0,0 +1,329 @@
+#include "pager.h"
+#include "editor.h"
+#include "screen.h"
+#include "screen80.h"
+#include "file_ops.h"
+#include "convert.h"
+#include <stdint.h>
+
+#define PAGER_LFN 2
+
+// Sparse index of byte offsets, one per ckpt_stride lines. When it
+// fills up every other entry is dropped and the stride doubles, so any
+// file length fits in a fixed 512 bytes.
+#define PAGER_MAX_CKPT 128
+
+// Lines kept above the screen when the window slides forward
+#define PAGER_SLACK ((LINES_PER_PAGE - EDIT_HEIGHT) / 2)
+
+static uint32_t ckpt[PAGER_MAX_CKPT];
+static int ckpt_count;
+static unsigned int ckpt_stride;
+
+static const DirEntry *src;
+static FileFormat view_format;
+
+// Stream position
+static uint32_t byte_pos;        // offset of the next byte
+static unsigned int next_line;   // number of the next line to be read
+static unsigned char at_eof;
+static unsigned char blk_len, blk_pos, blk_eof;
+
+// Window of consecutive lines held in lines[]
+static unsigned int win_first;
+static int win_count;
+static unsigned int top;         // first line on screen
+
+static unsigned char stream_open(void) {
+    char name[30];
+
+    dir_open_name(src, name);
+    cbm_k_setlfs(PAGER_LFN, current_drive, 2);
+    cbm_k_setnam(name);
+    if (cbm_k_open() != 0) return 0;
+
+    byte_pos = 0;
+    next_line = 0;
+    at_eof = 0;
+    blk_pos = 0;
+    blk_len = read_block(PAGER_LFN, io_buf, IO_BLOCK_SIZE, &blk_eof);
+
+    // Format is decided once, from the first block
+    if (ckpt_count == 0) {
+        conv_detect(io_buf, blk_len, &view_format);
+    }
+    conv_begin_input(&view_format);
+    return 1;
+}
+
+static int stream_getc(void) {
+    if (blk_pos >= blk_len) {
+        if (blk_eof) return -1;
+        blk_len = read_block(PAGER_LFN, io_buf, IO_BLOCK_SIZE, &blk_eof);
+        blk_pos = 0;
+        if (blk_len == 0) return -1;
+    }
+    byte_pos++;
+    return io_buf[blk_pos++];
+}
+
+static void add_checkpoint(void) {
+    int i;
+
+    if (next_line & (ckpt_stride - 1)) return;
+    if (next_line / ckpt_stride != (unsigned int)ckpt_count) return;
+
+    if (ckpt_count == PAGER_MAX_CKPT) {
+        for (i = 0; i < PAGER_MAX_CKPT / 2; i++) {
+            ckpt[i] = ckpt[i * 2];
+        }
+        ckpt_count = PAGER_MAX_CKPT / 2;
+        ckpt_stride <<= 1;
+        if (next_line & (ckpt_stride - 1)) return;
+    }
+
+    ckpt[ckpt_count++] = byte_pos;
+}
+
+// Read the next line from the stream into dst. Returns 0 at end of file.
+static unsigned char stream_read_line(char *dst) {
+    int pos = 0;
+    int ch;
+
+    if (at_eof) return 0;
+
+    add_checkpoint();
+
+    while ((ch = stream_getc()) >= 0) {
+        if (conv_feed((unsigned char)ch, dst, &pos)) {
+            next_line++;
+            return 1;
+        }
+    }
+
+    at_eof = 1;
+    if (pos > 0) {
+        dst[pos] = '\0';
+        next_line++;
+        return 1;
+    }
+    return 0;
+}
+
+// Reopen the file and skip to the checkpoint at or before line
+static void stream_seek(unsigned int line) {
+    int idx;
+    uint32_t target;
+    uint32_t left;
+
+    cbm_k_close(PAGER_LFN);
+    if (!stream_open()) {
+        at_eof = 1;
+        return;
+    }
+
+    idx = line / ckpt_stride;
+    if (idx >= ckpt_count) idx = ckpt_count - 1;
+    target = ckpt[idx];
+
+    // Skip whole blocks without looking at the bytes
+    while (byte_pos < target) {
+        left = target - byte_pos;
+        if (blk_pos >= blk_len) {
+            if (blk_eof) break;
+            blk_len = read_block(PAGER_LFN, io_buf, IO_BLOCK_SIZE, &blk_eof);
+            blk_pos = 0;
+            if (blk_len == 0) break;
+        }
+        if (left >= (uint32_t)(blk_len - blk_pos)) {
+            byte_pos += blk_len - blk_pos;
+            blk_pos = blk_len;
+        } else {
+            blk_pos += (unsigned char)left;
+            byte_pos = target;
+        }
+    }
+
+    next_line = idx * ckpt_stride;
+}
+
+// Make lines[] hold the lines starting at first
+static void window_fill(unsigned int first) {
+    char scratch[MAX_LINE_LENGTH];
+    int keep = 0;
+
+    if (first >= win_first && first <= win_first + win_count &&
+        next_line == win_first + win_count) {
+        // Slide forward, keeping the overlap
+        keep = win_count - (first - win_first);
+        memmove(lines[0], lines[first - win_first], keep * MAX_LINE_LENGTH);
+    } else {
+        if (first < next_line) {
+            stream_seek(first);
+        }
+        while (next_line < first && stream_read_line(scratch)) ;
+        if (next_line < first) first = next_line;
+    }
+
+    win_first = first;
+    win_count = keep;
+    while (win_count < LINES_PER_PAGE && stream_read_line(lines[win_count])) {
+        win_count++;
+    }
+}
+
+static unsigned char window_at_eof(void) {
+    return at_eof && next_line == win_first + win_count;
+}
+
+static void pager_goto(unsigned int want) {
+    unsigned int base;
+
+    if (want < win_first) {
+        // Going back - land the screen at the end of the new window
+        base = want + EDIT_HEIGHT > LINES_PER_PAGE ?
+               want + EDIT_HEIGHT - LINES_PER_PAGE : 0;
+        window_fill(base);
+    } else if (want + EDIT_HEIGHT > win_first + win_count && !window_at_eof()) {
+        base = want > PAGER_SLACK ? want - PAGER_SLACK : 0;
+        if (base < win_first) base = win_first;
+        window_fill(base);
+    }
+
+    // Never scroll past the last line
+    if (window_at_eof() && want >= win_first + win_count) {
+        want = win_first + win_count > 0 ? win_first + win_count - 1 : 0;
+    }
+    top = want;
+}
+
+static void pager_draw(void) {
+    char title[81];
+    unsigned int line;
+    int i;
+
+    if (screen_mode == MODE_80COL) screen80_begin_draw();
+
+    if (window_at_eof()) {
+        sprintf(title, "VIEW %.16s L%u/%u %s", src->name, top + 1,
+                win_first + win_count, conv_format_name(&view_format));
+    } else {
+        sprintf(title, "VIEW %.16s L%u %s", src->name, top + 1,
+                conv_format_name(&view_format));
+    }
+    draw_row_text(0, title, COL_YELLOW);
+
+    for (i = 0; i < EDIT_HEIGHT; i++) {
+        line = top + i;
+        if (line >= win_first && line < win_first + win_count) {
+            draw_row_text(i + 1, lines[line - win_first], COL_WHITE);
+        } else {
+            draw_row_text(i + 1, "", COL_WHITE);
+        }
+    }
+
+    if (screen_mode == MODE_80COL) screen80_end_draw();
+}
+
+// Find search_term after the top line, streaming forward as needed
+static void pager_find(void) {
+    unsigned int line = top + 1;
+
+    while (1) {
+        if (line < win_first || line >= win_first + win_count) {
+            if (window_at_eof() || cbm_k_getin() == KEY_STOP) break;
+            window_fill(line);
+            if (win_count == 0) break;
+            continue;
+        }
+        if (strstr(lines[line - win_first], search_term)) {
+            pager_goto(line);
+            pager_draw();
+            show_message("FOUND", COL_GREEN);
+            return;
+        }
+        line++;
+    }
+
+    pager_goto(top);
+    pager_draw();
+    show_message("NOT FOUND", COL_RED);
+}
+
+static void pager_prompt_search(void) {
+    int i = 0;
+
+    show_message("SEARCH FOR: ", COL_YELLOW);
+    while (1) {
+        char c = cgetc();
+        if (c == KEY_RETURN) break;
+        if (c == KEY_DELETE && i > 0) {
+            i--;
+            cputc_at(12 + i, 24, ' ', COL_YELLOW);
+        } else if (c >= 32 && c < 128 && i < 20) {
+            search_term[i] = c;
+            cputc_at(12 + i, 24, c, COL_YELLOW);
+            i++;
+        }
+    }
+    search_term[i] = '\0';
+
+    if (i > 0) {
+        pager_find();
+    } else {
+        show_message("SEARCH CANCELLED", COL_RED);
+    }
+}
+
+void pager_view(const DirEntry *entry) {
+    char c;
+
+    // Park the current page so lines[] can serve as the window
+    park_page();
+
+    src = entry;
+    ckpt_count = 0;
+    ckpt_stride = 32;
+    win_first = 0;
+    win_count = 0;
+    top = 0;
+
+    if (!stream_open()) {
+        show_message("ERROR LOADING", COL_RED);
+    } else {
+        window_fill(0);
+        pager_draw();
+        show_message("SPC=PAGE B=BACK F5=FIND F7=NEXT STOP=EXIT", COL_CYAN);
+
+        while ((c = cgetc()) != KEY_STOP) {
+            if (c == KEY_DOWN) {
+                pager_goto(top + 1);
+            } else if (c == KEY_UP) {
+                if (top > 0) pager_goto(top - 1);
+            } else if (c == ' ') {
+                pager_goto(top + EDIT_HEIGHT);
+            } else if (c == 'B' || c == 'b') {
+                pager_goto(top > EDIT_HEIGHT ? top - EDIT_HEIGHT : 0);
+            } else if (c == KEY_HOME) {
+                pager_goto(0);
+            } else if (c == KEY_F5) {
+                pager_prompt_search();
+                continue;
+            } else if (c == KEY_F7) {
+                if (search_term[0]) {
+                    pager_find();
+                } else {
+                    show_message("NO SEARCH - USE F5 FIRST", COL_RED);
+                }
+                continue;
+            } else {
+                continue;
+            }
+            pager_draw();
+        }
+        cbm_k_close(PAGER_LFN);
+    }
+
+    unpark_page();
+    update_cursor();
+}
@@ -0,0 +1,89 @@
+; 80-column row kernel - interface in include/font_tables.h
+;
+; Each bitmap cell holds two characters. Per cell the kernel looks up the
+; left glyph (high nibbles) and the right glyph (low nibbles) and writes
+; eight bytes of  lda (left),y / ora (right),y / eor rev / sta (dst),y  -
+; no masks, shifts or multiplies. A character with bit 7 set is shown
+; reversed: its half of rev is all ones. About 260 cycles a cell:
+;   glyph lookups 68, eight rows 168, pointer and loop upkeep 22.
+
+        .section .zp.bss,"zaw",@nobits
+        .globl r80_src, r80_dst, r80_col, r80_end
+r80_src:   .zero 2
+r80_dst:   .zero 2
+r80_col:   .zero 1
+r80_end:   .zero 1
+r80_left:  .zero 2
+r80_right: .zero 2
+r80_rev:   .zero 1
+
+        .section .text.r80_cells,"ax",@progbits
+        .globl r80_cells
+r80_cells:
+        ldy r80_col
+        cpy r80_end
+        bcs .Ldone
+
+.Lcell:
+        ; Left character -> r80_left, reversed in the high nibble
+        ldx #0
+        lda (r80_src),y
+        bpl 1f
+        ldx #$F0
+        and #$7F
+1:      stx r80_rev
+        tax
+        lda glyph_lo,x
+        sta r80_left
+        lda glyph_page,x
+        clc
+        adc #>font_lr
+        sta r80_left+1
+
+        ; Right character -> r80_right: same offset in the low-nibble half,
+        ; FONT_RIGHT (768) bytes on, and reversed in the low nibble
+        iny
+        lda (r80_src),y
+        bpl 2f
+        and #$7F
+        tax
+        lda r80_rev
+        ora #$0F
+        sta r80_rev
+        bne 3f
+2:      tax
+3:      lda glyph_lo,x
+        sta r80_right
+        lda glyph_page,x
+        clc
+        adc #>(font_lr + 768)
+        sta r80_right+1
+        iny
+        sty r80_col
+
+        ldy #0
+        .rept 7
+        lda (r80_left),y
+        ora (r80_right),y
+        eor r80_rev
+        sta (r80_dst),y
+        iny
+        .endr
+        lda (r80_left),y
+        ora (r80_right),y
+        eor r80_rev
+        sta (r80_dst),y
+
+        ; Next cell is 8 bytes on
+        lda r80_dst
+        clc
+        adc #8
+        sta r80_dst
+        bcc 4f
+        inc r80_dst+1
+4:      ldy r80_col
+        cpy r80_end
+        bcc .Lcell
+
+.Ldone:
+        rts
@@ -5,7 +5,10 @@
 
 static uint8_t reu_available = 0;
 static uint32_t reu_size = 0;
-static int reu_max_pages = 0;
+static int reu_max_pages = 0;     // pages in the active window
+static int reu_total_pages = 0;   // pages below the reserved areas
+static int reu_page_base = 0;     // first page of the active window
+static REUPtr reu_top = 0;        // start of the areas reserved by reu_reserve
 
 // Page header structure stored in REU
 typedef struct {
@@ -24,7 +27,7 @@ typedef struct {
 #define DMA_BARRIER() __asm__ volatile("" ::: "memory")
 
 static REUPtr reu_page_addr(int page_num) {
-    return REU_DATA_OFFSET + ((REUPtr)page_num * REU_PAGE_SIZE);
+    return REU_DATA_OFFSET + ((REUPtr)(reu_page_base + page_num) * REU_PAGE_SIZE);
 }
 
 uint8_t reu_detect(void) {
@@ -57,14 +60,41 @@ void reu_init(void) {
         REU_REGS.control = 0;
         REU_REGS.reu_bank = 0;
         reu_size = reu_get_size();
+        reu_top = reu_size;
         if (reu_size > 0) {
             reu_max_pages = (reu_size - REU_DATA_OFFSET) / REU_PAGE_SIZE;
         } else {
             reu_max_pages = 0;
         }
+        reu_total_pages = reu_max_pages;
     }
 }
 
+// Carve a fixed area off the top of the REU for another module. The
+// page store shrinks to fit below it, so this must be called at startup
+// before any page has been stored. Returns 0 if there is no room.
+REUPtr reu_reserve(uint32_t size) {
+    if (!reu_available) return 0;
+    if (reu_top < REU_DATA_OFFSET + size + REU_PAGE_SIZE) return 0;
+
+    reu_top -= size;
+    reu_total_pages = (reu_top - REU_DATA_OFFSET) / REU_PAGE_SIZE;
+    reu_max_pages = reu_total_pages;
+    reu_page_base = 0;
+    return reu_top;
+}
+
+// Restrict page numbers to a window of the page store, so several
+// documents can each number their pages from 0
+void reu_set_page_window(int first, int count) {
+    reu_page_base = first;
+    reu_max_pages = count;
+}
+
+int reu_total_page_count(void) {
+    return reu_total_pages;
+}
+
 uint8_t reu_is_available(void) {
     return reu_available;
 }
@@ -91,6 +121,33 @@ void reu_write(REUPtr reu_addr, void* c64_addr, uint16_t size) {
     REU_REGS.command = REU_CMD_STASH;  // DMA happens here - CPU halted
 }
 
+// Exchange size bytes of C64 memory with the REU, 2 cycles per byte
+void reu_swap(REUPtr reu_addr, void *c64_addr, uint16_t size) {
+    if (!reu_available || size == 0) return;
+
+    DMA_BARRIER();
+    REU_SET_C64_ADDR((uint16_t)c64_addr);
+    REU_SET_REU_ADDR(reu_addr);
+    REU_SET_LENGTH(size);
+    REU_REGS.control = 0;
+    REU_REGS.command = REU_CMD_SWAP;
+    DMA_BARRIER();
+}
+
+// Load the registers for a transfer without starting it. With an armed
+// command the DMA begins on the next write to $FF00.
+void reu_arm(uint8_t command, REUPtr reu_addr, void *c64_addr, uint16_t size,
+             uint8_t control) {
+    if (!reu_available || size == 0) return;
+
+    DMA_BARRIER();
+    REU_SET_C64_ADDR((uint16_t)c64_addr);
+    REU_SET_REU_ADDR(reu_addr);
+    REU_SET_LENGTH(size);
+    REU_REGS.control = control;
+    REU_REGS.command = command;
+}
+
 int reu_max_page_count(void) {
     return reu_max_pages;
 }
@@ -147,6 +204,19 @@ int reu_load_page(int page_num) {
     return header.num_lines_stored;
 }
 
+// Raw pages hold binary data in the same slots, without a header
+void reu_save_raw_page(int page_num, void *buf, uint16_t size) {
+    if (!reu_available) return;
+    if (page_num >= reu_max_pages) return;
+    reu_write(reu_page_addr(page_num), buf, size);
+}
+
+void reu_load_raw_page(int page_num, void *buf, uint16_t size) {
+    if (!reu_available) return;
+    if (page_num >= reu_max_pages) return;
+    reu_read(reu_page_addr(page_num), buf, size);
+}
+
 uint32_t reu_get_size(void) {
     // Must be volatile - REU DMA reads/writes these behind the compiler's back
     static volatile uint8_t test_byte;
@@ -1,6 +1,36 @@
 #include "screen.h"
 #include "screen80.h"
 #include "editor_state.h"
+#include "docs.h"
+#include "basic.h"
+#include "highlight.h"
+#include "frame.h"
+#include "reu.h"
+
+// ASCII/PETSCII -> VIC screen code (lower/upper charset)
+// The charset has no backslash, braces or tilde. \ shows as the pound
+// sign that PETSCII keeps at the same code, { } as ( ), ~ as -, ^ as the
+// up arrow, _ as a bottom bar and | as a vertical line - all non-letters
+// that exist in this charset.
+static const unsigned char screen_codes[256] = {
+    /* 00 */ 0x00,0x01,0x02,0x03,0x04,0x05,0x06,0x07,0x08,0x09,0x0A,0x0B,0x0C,0x0D,0x0E,0x0F,
+    /* 10 */ 0x10,0x11,0x12,0x13,0x14,0x15,0x16,0x17,0x18,0x19,0x1A,0x1B,0x1C,0x1D,0x1E,0x1F,
+    /* 20 */ 0x20,0x21,0x22,0x23,0x24,0x25,0x26,0x27,0x28,0x29,0x2A,0x2B,0x2C,0x2D,0x2E,0x2F,
+    /* 30 */ 0x30,0x31,0x32,0x33,0x34,0x35,0x36,0x37,0x38,0x39,0x3A,0x3B,0x3C,0x3D,0x3E,0x3F,
+    /* 40 */ 0x00,0x41,0x42,0x43,0x44,0x45,0x46,0x47,0x48,0x49,0x4A,0x4B,0x4C,0x4D,0x4E,0x4F,
+    /* 50 */ 0x50,0x51,0x52,0x53,0x54,0x55,0x56,0x57,0x58,0x59,0x5A,0x1B,0x1C,0x1D,0x1E,0x64,
+    /* 60 */ 0x27,0x01,0x02,0x03,0x04,0x05,0x06,0x07,0x08,0x09,0x0A,0x0B,0x0C,0x0D,0x0E,0x0F,
+    /* 70 */ 0x10,0x11,0x12,0x13,0x14,0x15,0x16,0x17,0x18,0x19,0x1A,0x28,0x5D,0x29,0x2D,0x20,
+    /* 80 */ 0x80,0x81,0x82,0x83,0x84,0x85,0x86,0x87,0x88,0x89,0x8A,0x8B,0x8C,0x8D,0x8E,0x8F,
+    /* 90 */ 0x90,0x91,0x92,0x93,0x94,0x95,0x96,0x97,0x98,0x99,0x9A,0x9B,0x9C,0x9D,0x9E,0x9F,
+    /* A0 */ 0x20,0x61,0x62,0x63,0x64,0x65,0x66,0x67,0x68,0x69,0x6A,0x6B,0x6C,0x6D,0x6E,0x6F,
+    /* B0 */ 0x70,0x71,0x72,0x73,0x74,0x75,0x76,0x77,0x78,0x79,0x7A,0x7B,0x7C,0x7D,0x7E,0x7F,
+    /* C0 */ 0x40,0x41,0x42,0x43,0x44,0x45,0x46,0x47,0x48,0x49,0x4A,0x4B,0x4C,0x4D,0x4E,0x4F,
+    /* D0 */ 0x50,0x51,0x52,0x53,0x54,0x55,0x56,0x57,0x58,0x59,0x5A,0x5B,0x5C,0x5D,0x5E,0x5F,
+    /* E0 */ 0x60,0x61,0x62,0x63,0x64,0x65,0x66,0x67,0x68,0x69,0x6A,0x6B,0x6C,0x6D,0x6E,0x6F,
+    /* F0 */ 0x70,0x71,0x72,0x73,0x74,0x75,0x76,0x77,0x78,0x79,0x7A,0x7B,0x7C,0x7D,0x7E,0x7F,
+};
+
 
 void clrscr() {
     if (screen_mode == MODE_80COL) {
@@ -26,7 +56,7 @@ void cputc_at(int x, int y, char c, unsigned char color) {
         return;
     }
     int pos = y * SCREEN_WIDTH + x;
-    SCREEN_RAM[pos] = c;
+    SCREEN_RAM[pos] = screen_codes[(unsigned char)c];
     COLOR_RAM[pos] = color;
 }
 
@@ -37,20 +67,14 @@ void cputs_at(int x, int y, const char *s, unsigned char color) {
     }
     int pos = y * SCREEN_WIDTH + x;
     while (*s) {
-        SCREEN_RAM[pos] = *s++;
+        SCREEN_RAM[pos] = screen_codes[(unsigned char)*s++];
         COLOR_RAM[pos] = color;
         pos++;
     }
 }
 
 int is_basic_keyword(const char *word) {
-    int i;
-    for (i = 0; basic_keywords[i] != NULL; i++) {
-        if (strcmp(word, basic_keywords[i]) == 0) {
-            return 1;
-        }
-    }
-    return 0;
+    return basic_token(word, strlen(word)) != 0;
 }
 
 void draw_line_number(int screen_row, int line_num) {
@@ -81,173 +105,575 @@ void draw_line_number(int screen_row, int line_num) {
     }
 }
 
-void draw_text_line(int screen_row, int line_num) {
+// Marked columns sel_from..sel_to-1 of line_num on the current page.
+// The mark may run either way and across pages, so it is put in order
+// here once per row rather than once per character.
+static void mark_row_span(int line_num, int len, int *sel_from, int *sel_to) {
+    int sp = mark_start_page, sy = mark_start_y, sx = mark_start_x;
+    int ep = mark_end_page, ey = mark_end_y, ex = mark_end_x;
+    int t;
+
+    *sel_from = *sel_to = 0;
+    if (!mark_active) return;
+
+    if (ep < sp || (ep == sp && (ey < sy || (ey == sy && ex < sx)))) {
+        t = sp; sp = ep; ep = t;
+        t = sy; sy = ey; ey = t;
+        t = sx; sx = ex; ex = t;
+    }
+
+    if (current_page < sp || (current_page == sp && line_num < sy)) return;
+    if (current_page > ep || (current_page == ep && line_num > ey)) return;
+
+    *sel_from = (current_page == sp && line_num == sy) ? sx : 0;
+    *sel_to = (current_page == ep && line_num == ey) ? ex : len;
+    if (*sel_to > len) *sel_to = len;
+}
+
+// Start decoding a line's color runs at text column col. Returns where
+// the next run is, with the class and length left of the current one.
+static const unsigned char *runs_from(const unsigned char *run, int col,
+                                      unsigned char *cls, unsigned char *left) {
+    while (*run && HL_RUN_LEN(*run) <= col) col -= HL_RUN_LEN(*run++);
+    if (*run) {
+        *cls = HL_RUN_CLASS(*run);
+        *left = HL_RUN_LEN(*run) - col;
+        return run + 1;
+    }
+    // Past the last run everything is text
+    *cls = HL_TEXT;
+    *left = 255;
+    return run;
+}
+
+// Move on one column, to the next run when this one is used up
+#define RUN_STEP(run, cls, left) \
+    if (--left == 0) run = runs_from(run, 0, &cls, &left)
+
+// Draw screen columns from..to-1 of a text row, line number included
+static void draw_text_span(int screen_row, int line_num, int from, int to) {
     int ew = edit_width;
+    const unsigned char *run;
+    unsigned char cls, left;
 
     if (screen_mode == MODE_80COL) {
-        // Fast path: build 80-char buffer, render entire row at once
+        // One pass over the line builds the characters, with marked ones
+        // reversed, and a color per cell; the renderer takes both whole
         char rowbuf[80];
-        int i, len;
+        uint8_t colors[40];
+        const char *text;
+        char c;
+        int i, x, len, sel_from, sel_to;
+
+        memset(colors, COL_WHITE, sizeof(colors));
 
         if (line_num < num_lines) {
+            text = lines[line_num];
+            len = strlen(text);
+            if (len > ew) len = ew;
+            mark_row_span(line_num, len, &sel_from, &sel_to);
+            run = runs_from(hl_runs(line_num), 0, &cls, &left);
+
             rowbuf[0] = (line_num / 10) + '0';
             rowbuf[1] = (line_num % 10) + '0';
             rowbuf[2] = ':';
-            len = strlen(lines[line_num]);
-            for (i = 0; i < ew && i < len; i++)
-                rowbuf[3 + i] = lines[line_num][i];
+            colors[0] = COL_CYAN;
+
+            for (i = 0; i < len; i++) {
+                // A cell takes its left character's color, unless the
+                // right one is highlighted
+                x = 3 + i;
+                if (!(x & 1) || cls != HL_TEXT) colors[x >> 1] = hl_colors[cls];
+                RUN_STEP(run, cls, left);
+
+                c = text[i] & 0x7F;
+                if (i >= sel_from && i < sel_to) c |= 0x80;
+                rowbuf[x] = c;
+            }
             for (; i < ew; i++)
                 rowbuf[3 + i] = ' ';
         } else {
             memset(rowbuf, ' ', 3 + ew);
         }
 
-        render_line_80(screen_row, rowbuf, 3 + ew, 0, 80, COL_WHITE);
+        render_line_80(screen_row, rowbuf, 3 + ew, from, to - from, COL_WHITE, colors);
         return;
     }
 
-    // 40-col path
+    // 40-col path: compose the span's screen codes and colors in two row
+    // buffers, indexed by screen column, then copy both to the screen
     {
-        int i, j;
-        char word[20];
-        int word_len = 0;
-        unsigned char color;
-        int keyword_start = -1;
+        unsigned char codes[SCREEN_WIDTH], colors[SCREEN_WIDTH];
+        const char *text = "";
+        int i, end, len = 0, sel_from = 0, sel_to = 0;
+
+        if (to > LINE_NUM_WIDTH + ew) to = LINE_NUM_WIDTH + ew;
+        if (from >= to) return;
+
+        if (from < LINE_NUM_WIDTH) {
+            if (line_num < num_lines) {
+                codes[0] = (line_num / 10) + '0';
+                codes[1] = (line_num % 10) + '0';
+                codes[2] = ':';
+            } else {
+                codes[0] = codes[1] = codes[2] = ' ';
+            }
+            colors[0] = colors[1] = colors[2] = COL_CYAN;
+            i = 0;
+        } else {
+            i = from - LINE_NUM_WIDTH;
+        }
 
+        end = to - LINE_NUM_WIDTH;
         if (line_num < num_lines) {
-            int len = strlen(lines[line_num]);
-            int is_marked;
-
-            for (i = 0; i < ew; i++) {
-                color = COL_WHITE;
-                is_marked = 0;
-
-                if (mark_active) {
-                    int start_y = mark_start_y < mark_end_y ? mark_start_y : mark_end_y;
-                    int end_y = mark_start_y < mark_end_y ? mark_end_y : mark_start_y;
-
-                    if (line_num >= start_y && line_num <= end_y) {
-                        if (start_y == end_y) {
-                            int start_x = mark_start_x < mark_end_x ? mark_start_x : mark_end_x;
-                            int end_x = mark_start_x < mark_end_x ? mark_end_x : mark_start_x;
-                            is_marked = (i >= start_x && i < end_x);
-                        } else if (line_num == start_y) {
-                            is_marked = (i >= (line_num == mark_start_y ? mark_start_x : 0));
-                        } else if (line_num == end_y) {
-                            is_marked = (i < (line_num == mark_end_y ? mark_end_x : len));
-                        } else {
-                            is_marked = 1;
-                        }
-                    }
-                }
-
-                if (i < len) {
-                    char c = lines[line_num][i];
-
-                    if (basic_mode && (isupper(c) || c == '$' || c == '%')) {
-                        if (word_len == 0) keyword_start = i;
-                        if (word_len < 19) {
-                            word[word_len++] = c;
-                        }
-                    } else {
-                        if (word_len > 0) {
-                            word[word_len] = '\0';
-                            if (basic_mode && is_basic_keyword(word)) {
-                                for (j = 0; j < word_len; j++) {
-                                    cputc_at(3 + keyword_start + j, screen_row,
-                                             lines[line_num][keyword_start + j], COL_PURPLE);
-                                }
-                            }
-                            word_len = 0;
-                        }
-                    }
-
-                    if (is_marked) {
-                        color = COL_YELLOW;
-                    }
-                    cputc_at(3 + i, screen_row, c, color);
-                } else {
-                    cputc_at(3 + i, screen_row, ' ', COL_WHITE);
-                }
+            text = lines[line_num];
+            len = strlen(text);
+            if (len > end) len = end;
+            mark_row_span(line_num, len, &sel_from, &sel_to);
+            run = runs_from(hl_runs(line_num), i, &cls, &left);
+
+            for (; i < len; i++) {
+                codes[3 + i] = screen_codes[(unsigned char)text[i]];
+                colors[3 + i] = (i >= sel_from && i < sel_to) ? COL_YELLOW : hl_colors[cls];
+                RUN_STEP(run, cls, left);
             }
+        }
+        for (; i < end; i++) {
+            codes[3 + i] = ' ';
+            colors[3 + i] = COL_WHITE;
+        }
 
-            if (word_len > 0) {
-                word[word_len] = '\0';
-                if (basic_mode && is_basic_keyword(word)) {
-                    for (j = 0; j < word_len; j++) {
-                        cputc_at(3 + keyword_start + j, screen_row,
-                                 lines[line_num][keyword_start + j], COL_PURPLE);
-                    }
-                }
-            }
+        i = screen_row * SCREEN_WIDTH + from;
+        memcpy(SCREEN_RAM + i, codes + from, to - from);
+        memcpy((uint8_t *)COLOR_RAM + i, colors + from, to - from);
+    }
+}
+
+void draw_text_line(int screen_row, int line_num) {
+    // In 80-col mode the row is rendered whole, line number included
+    if (screen_mode == MODE_80COL) {
+        draw_text_span(screen_row, line_num, 0, SCREEN_WIDTH_80);
+    } else {
+        draw_text_span(screen_row, line_num, LINE_NUM_WIDTH, LINE_NUM_WIDTH + edit_width);
+    }
+}
+
+// Shift text rows 1..EDIT_HEIGHT of the 40-col screen by one row, up
+// (dir > 0) or down. Every row address is a constant, so each byte is an
+// indexed load and store with no pointer arithmetic.
+#define SHIFT_ROW(dst, src) \
+    SCREEN_RAM[(dst) * SCREEN_WIDTH + x] = SCREEN_RAM[(src) * SCREEN_WIDTH + x]; \
+    COLOR_RAM[(dst) * SCREEN_WIDTH + x] = COLOR_RAM[(src) * SCREEN_WIDTH + x];
+
+static void scroll_text_40(signed char dir) {
+    unsigned char x;
+
+    if (dir > 0) {
+        for (x = 0; x < SCREEN_WIDTH; x++) {
+            SHIFT_ROW(1, 2)   SHIFT_ROW(2, 3)   SHIFT_ROW(3, 4)   SHIFT_ROW(4, 5)
+            SHIFT_ROW(5, 6)   SHIFT_ROW(6, 7)   SHIFT_ROW(7, 8)   SHIFT_ROW(8, 9)
+            SHIFT_ROW(9, 10)  SHIFT_ROW(10, 11) SHIFT_ROW(11, 12) SHIFT_ROW(12, 13)
+            SHIFT_ROW(13, 14) SHIFT_ROW(14, 15) SHIFT_ROW(15, 16) SHIFT_ROW(16, 17)
+            SHIFT_ROW(17, 18) SHIFT_ROW(18, 19) SHIFT_ROW(19, 20) SHIFT_ROW(20, 21)
+            SHIFT_ROW(21, 22) SHIFT_ROW(22, 23)
+        }
+    } else {
+        for (x = 0; x < SCREEN_WIDTH; x++) {
+            SHIFT_ROW(23, 22) SHIFT_ROW(22, 21) SHIFT_ROW(21, 20) SHIFT_ROW(20, 19)
+            SHIFT_ROW(19, 18) SHIFT_ROW(18, 17) SHIFT_ROW(17, 16) SHIFT_ROW(16, 15)
+            SHIFT_ROW(15, 14) SHIFT_ROW(14, 13) SHIFT_ROW(13, 12) SHIFT_ROW(12, 11)
+            SHIFT_ROW(11, 10) SHIFT_ROW(10, 9)  SHIFT_ROW(9, 8)   SHIFT_ROW(8, 7)
+            SHIFT_ROW(7, 6)   SHIFT_ROW(6, 5)   SHIFT_ROW(5, 4)   SHIFT_ROW(4, 3)
+            SHIFT_ROW(3, 2)   SHIFT_ROW(2, 1)
+        }
+    }
+}
+
+#undef SHIFT_ROW
+#if EDIT_HEIGHT != 23
+#error "scroll_text_40 is unrolled for 23 text rows"
+#endif
+
+// Damage tracking. Operations record what they changed and screen_flush()
+// draws only that: a column span per text row, plus title/status fields.
+// Cursor, scroll and page changes are found by comparing against what
+// the last flush showed.
+#define SPAN_CLEAN 0xFF
+
+static unsigned char span_from[EDIT_HEIGHT];
+static unsigned char span_to[EDIT_HEIGHT];
+static unsigned char dirty_fields;
+
+// State as of the last flush; shown_x < 0 means nothing valid is shown
+static int shown_x = -1, shown_y, shown_scroll, shown_page, shown_pages;
+
+// The same for the screen mode not on display, which keeps what it last
+// showed: the rows damaged since then are redrawn when it comes back.
+// Rows are only comparable while both views share a scroll position.
+static unsigned char hidden_rows[EDIT_HEIGHT];
+static unsigned char hidden_fields;
+static int hidden_x = -1, hidden_y, hidden_scroll, hidden_page, hidden_pages;
+
+// Off while the flush works out what cursor and view moves redraw: that
+// is not a change to the text the hidden screen shows
+static unsigned char track_hidden = 1;
+
+static void damage_row(int row, int from, int to) {
+    if (row < 0 || row >= EDIT_HEIGHT) return;
+    if (from < 0) from = 0;
+    if (to > screen_width) to = screen_width;
+    if (from >= to) return;
+
+    if (track_hidden) hidden_rows[row] = 1;
+    if (span_from[row] == SPAN_CLEAN) {
+        span_from[row] = from;
+        span_to[row] = to;
+    } else {
+        if (from < span_from[row]) span_from[row] = from;
+        if (to > span_to[row]) span_to[row] = to;
+    }
+}
+
+void damage_all(void) {
+    int i;
+
+    for (i = 0; i < EDIT_HEIGHT; i++) {
+        span_from[i] = 0;
+        span_to[i] = screen_width;
+    }
+    memset(hidden_rows, 1, EDIT_HEIGHT);
+    dirty_fields = DMG_TITLE | DMG_STATUS;
+}
+
+void damage_fields(unsigned char fields) {
+    dirty_fields |= fields;
+}
+
+void damage_span(int line_num, int from, int to) {
+    damage_row(line_num - scroll_offset, from + LINE_NUM_WIDTH, to + LINE_NUM_WIDTH);
+}
+
+void damage_lines(int first, int last) {
+    int i;
+
+    for (i = first; i <= last; i++) {
+        damage_row(i - scroll_offset, 0, screen_width);
+    }
+}
+
+// Text rows shifted by the next flush: 1 = up, -1 = down
+static signed char pending_scroll;
+
+// Work out what moving the cursor since the last flush changed
+static void damage_cursor(void) {
+    int lo, hi;
+
+    // A one-line scroll moves what is on screen and exposes one row
+    if (shown_x >= 0 && current_page == shown_page &&
+        (scroll_offset == shown_scroll + 1 || scroll_offset == shown_scroll - 1)) {
+        pending_scroll = scroll_offset - shown_scroll;
+        // Rows dirtied before the move follow their lines
+        if (pending_scroll > 0) {
+            memmove(span_from, span_from + 1, EDIT_HEIGHT - 1);
+            memmove(span_to, span_to + 1, EDIT_HEIGHT - 1);
+            damage_lines(scroll_offset + EDIT_HEIGHT - 1, scroll_offset + EDIT_HEIGHT - 1);
         } else {
-            for (i = 0; i < ew; i++) {
-                cputc_at(3 + i, screen_row, ' ', COL_WHITE);
-            }
+            memmove(span_from + 1, span_from, EDIT_HEIGHT - 1);
+            memmove(span_to + 1, span_to, EDIT_HEIGHT - 1);
+            span_from[0] = SPAN_CLEAN;
+            damage_lines(scroll_offset, scroll_offset);
+        }
+        shown_scroll = scroll_offset;
+        dirty_fields |= DMG_POS;
+    }
+
+    if (shown_x < 0 || scroll_offset != shown_scroll || current_page != shown_page) {
+        damage_lines(scroll_offset, scroll_offset + EDIT_HEIGHT - 1);
+        dirty_fields |= DMG_POS | DMG_FLAGS;
+        return;
+    }
+
+    if (num_pages != shown_pages) dirty_fields |= DMG_FLAGS;
+
+    // Old cell loses the cursor, new cell is drawn plain before it gets one
+    damage_span(shown_y, shown_x, shown_x + 1);
+    damage_span(cursor_y, cursor_x, cursor_x + 1);
+
+    if (cursor_x == shown_x && cursor_y == shown_y) return;
+    dirty_fields |= DMG_POS;
+
+    // A moving mark end re-highlights what the cursor passed over
+    if (mark_active) {
+        track_hidden = 1;
+        if (cursor_y == shown_y) {
+            lo = cursor_x < shown_x ? cursor_x : shown_x;
+            hi = cursor_x < shown_x ? shown_x : cursor_x;
+            damage_span(cursor_y, lo, hi + 1);
+        } else {
+            lo = cursor_y < shown_y ? cursor_y : shown_y;
+            hi = cursor_y < shown_y ? shown_y : cursor_y;
+            damage_lines(lo, hi);
         }
     }
 }
 
-void redraw_screen() {
+// Write s at x, padded with spaces to width
+static void cputs_field(int x, int width, const char *s, unsigned char color) {
+    char buf[20];
     int i;
-    char title[80];
-    int global_line = current_page * LINES_PER_PAGE + cursor_y + 1;
+
+    for (i = 0; i < width && s[i]; i++) buf[i] = s[i];
+    for (; i < width; i++) buf[i] = ' ';
+    buf[i] = '\0';
+    cputs_at(x, 0, buf, color);
+}
+
+static void draw_title(unsigned char fields) {
+    int i;
+    char title[20];
     int sw = screen_width;
 
-    if (current_filename[0] != '\0') {
-        sprintf(title, "%.8s", current_filename);
-        cputs_at(0, 0, title, COL_YELLOW);
-    } else {
-        cputs_at(0, 0, "WHISPER", COL_YELLOW);
+    if (fields & DMG_NAME) {
+        if (doc_slots > 1) {
+            // Slot number takes the front of the name field
+            sprintf(title, "%d:%-6.6s", doc_slot + 1,
+                    current_filename[0] ? current_filename : "NEW");
+        } else if (current_filename[0] != '\0') {
+            sprintf(title, "%.8s", current_filename);
+        } else {
+            strcpy(title, "WHISPER");
+        }
+        cputs_field(0, 8, title, COL_YELLOW);
+    }
+
+    if (fields & DMG_POS) {
+        int global_line = current_page * LINES_PER_PAGE + cursor_y + 1;
+        sprintf(title, " %d:%d", global_line, cursor_x + 1);
+        cputs_field(8, 9, title, COL_GREEN);
     }
 
-    char pos_info[15];
-    sprintf(pos_info, " %d:%d", global_line, cursor_x + 1);
-    cputs_at(8, 0, pos_info, COL_GREEN);
+    if (fields & DMG_FLAGS) {
+        int next_x = 17;
+        int drive_pos = sw - 10;
+        int page_pos = sw - 18;
+
+        if (basic_mode) {
+            cputs_at(next_x, 0, "[BAS]", COL_PURPLE);
+            next_x += 5;
+        }
+
+        if (mark_active) {
+            cputs_at(next_x, 0, "[M]", COL_GREEN);
+            next_x += 3;
+        }
+
+        sprintf(title, " D:%d", current_drive);
+        cputs_field(drive_pos, 6, title, COL_CYAN);
+
+        if (num_pages > 1) {
+            sprintf(title, " P%d/%d", current_page + 1, num_pages);
+            cputs_field(page_pos, 8, title, COL_CYAN);
+        } else {
+            cputs_field(page_pos, 8, "", COL_CYAN);
+        }
 
-    int next_x = 17;
-    if (basic_mode) {
-        cputs_at(next_x, 0, "[BAS]", COL_PURPLE);
-        next_x += 5;
+        if (screen_mode == MODE_80COL) {
+            cputs_at(sw - 4, 0, "80C", COL_GREEN);
+        }
+
+        // Clear gap in title bar
+        for (i = next_x; i < page_pos; i++) {
+            cputc_at(i, 0, ' ', COL_YELLOW);
+        }
     }
+}
 
-    if (mark_active) {
-        cputs_at(next_x, 0, "[M]", COL_GREEN);
-        next_x += 3;
+// Set while damage is waiting for screen_slice()
+static unsigned char flush_wanted;
+
+// Draw the damage. A budgeted slice stops once the frame budget is used
+// and leaves the rows it did not reach dirty; the cursor's row goes first
+// so the cursor never lags behind.
+static void flush_slice(unsigned char budgeted) {
+    int i, rows, cursor_row;
+    unsigned char more = 0;
+
+    track_hidden = 0;
+    damage_cursor();
+    track_hidden = 1;
+    if (scroll_offset != hidden_scroll || current_page != hidden_page) hidden_x = -1;
+    hidden_fields |= dirty_fields;
+
+    for (i = 0, rows = 0; i < EDIT_HEIGHT; i++) {
+        if (span_from[i] != SPAN_CLEAN) rows++;
     }
+    // Big changes start in the lower border, ahead of the beam
+    if (budgeted && (pending_scroll || rows > EDIT_HEIGHT / 2)) frame_wait();
+    frame_slice_begin();
 
-    int drive_pos = sw - 10;
-    char drive_info[10];
-    sprintf(drive_info, " D:%d", current_drive);
-    cputs_at(drive_pos, 0, drive_info, COL_CYAN);
+    if (mouse_is_enabled()) {
+        mouse_hide_cursor();
+    }
 
-    int page_pos = sw - 18;
-    if (num_pages > 1) {
-        char page_info[10];
-        sprintf(page_info, " P%d/%d", current_page + 1, num_pages);
-        cputs_at(page_pos, 0, page_info, COL_CYAN);
+    // Batch all bitmap + color writes under one ROM banking operation
+    if (screen_mode == MODE_80COL) screen80_begin_draw();
+
+    if (pending_scroll) {
+        if (screen_mode == MODE_80COL) {
+            scroll_rows(1, EDIT_HEIGHT, pending_scroll);
+        } else {
+            scroll_text_40(pending_scroll);
+        }
+        pending_scroll = 0;
     }
 
+    // Redrawing most of the bitmap in place would tear - build it off screen
+    if (screen_mode == MODE_80COL && rows > EDIT_HEIGHT / 2) screen80_frame_begin();
+
+    if (dirty_fields & DMG_TITLE) draw_title(dirty_fields);
+
+    cursor_row = cursor_y - scroll_offset;
+    if (cursor_row >= 0 && cursor_row < EDIT_HEIGHT && span_from[cursor_row] != SPAN_CLEAN) {
+        draw_text_span(cursor_row + 1, cursor_y, span_from[cursor_row], span_to[cursor_row]);
+        span_from[cursor_row] = SPAN_CLEAN;
+    }
+
+    for (i = 0; i < EDIT_HEIGHT; i++) {
+        if (span_from[i] == SPAN_CLEAN) continue;
+        if (budgeted && frame_slice_over()) {
+            more = 1;
+            break;
+        }
+        draw_text_span(i + 1, scroll_offset + i, span_from[i], span_to[i]);
+        span_from[i] = SPAN_CLEAN;
+    }
+
+    if (dirty_fields & DMG_STATUS) {
+        for (i = 0; i < screen_width; i++) {
+            cputc_at(i, 24, ' ', COL_CYAN);
+        }
+    }
+    dirty_fields = 0;
+
+    draw_cursor();
+
     if (screen_mode == MODE_80COL) {
-        cputs_at(sw - 4, 0, "80C", COL_GREEN);
+        screen80_frame_end();
+        screen80_end_draw();
     }
 
-    // Clear gap in title bar
-    for (i = next_x; i < page_pos; i++) {
-        cputc_at(i, 0, ' ', COL_YELLOW);
+    if (mouse_is_enabled()) {
+        mouse_draw_cursor();
     }
 
+    shown_x = cursor_x;
+    shown_y = cursor_y;
+    shown_scroll = scroll_offset;
+    shown_page = current_page;
+    shown_pages = num_pages;
+    flush_wanted = more;
+}
+
+void screen_flush(void) {
+    flush_slice(0);
+}
+
+// Trade the shown and hidden states after a CTRL+D flip. Damage not yet
+// drawn stays with the screen it was meant for.
+void screen_switch(void) {
+    int i, t;
+    unsigned char pending;
+
+#define SWAP(a, b) (t = a, a = b, b = t)
+    SWAP(shown_x, hidden_x);
+    SWAP(shown_y, hidden_y);
+    SWAP(shown_scroll, hidden_scroll);
+    SWAP(shown_page, hidden_page);
+    SWAP(shown_pages, hidden_pages);
+    SWAP(dirty_fields, hidden_fields);
+#undef SWAP
+
     for (i = 0; i < EDIT_HEIGHT; i++) {
-        // In 80-col mode, draw_text_line includes line numbers
-        if (screen_mode != MODE_80COL) {
-            draw_line_number(i + 1, scroll_offset + i);
+        pending = span_from[i] != SPAN_CLEAN;
+        if (hidden_rows[i]) {
+            span_from[i] = 0;
+            span_to[i] = screen_width;
+        } else {
+            span_from[i] = SPAN_CLEAN;
         }
-        draw_text_line(i + 1, scroll_offset + i);
+        hidden_rows[i] = pending;
+    }
+
+    // Never shown, or its view has moved on: the flush redraws it all
+    if (shown_x < 0) dirty_fields |= DMG_TITLE | DMG_STATUS;
+    screen_flush();
+}
+
+void screen_schedule(void) {
+    // Damage is kept by screen row, so a moved view is drawn (or at least
+    // scrolled) now, before more damage is recorded against it
+    if (shown_x < 0 || scroll_offset != shown_scroll || current_page != shown_page) {
+        flush_slice(1);
+    } else {
+        flush_wanted = 1;
+    }
+}
+
+unsigned char screen_pending(void) {
+    return flush_wanted;
+}
+
+void screen_slice(void) {
+    flush_slice(1);
+}
+
+// Reverse one character cell in place
+void invert_cell(int x, int y) {
+    if (screen_mode == MODE_80COL) {
+        // In bitmap mode: XOR the 4px half of the cell's bitmap bytes
+        invert_cell_80(x, y);
+    } else {
+        SCREEN_RAM[y * SCREEN_WIDTH + x] ^= 0x80;
+    }
+}
+
+// Move screen rows top..bottom one row up (dir > 0) or down (dir < 0).
+// The row left behind keeps its old contents for the caller to redraw.
+void scroll_rows(int top, int bottom, signed char dir) {
+    uint16_t span;
+
+    if (bottom <= top) return;
+
+    if (screen_mode == MODE_80COL) {
+        screen80_move_rows(top, bottom, dir);
+        return;
+    }
+
+    span = (bottom - top) * SCREEN_WIDTH;
+    if (dir > 0) {
+        memmove(SCREEN_RAM + top * SCREEN_WIDTH, SCREEN_RAM + (top + 1) * SCREEN_WIDTH, span);
+        memmove((uint8_t *)COLOR_RAM + top * SCREEN_WIDTH, (uint8_t *)COLOR_RAM + (top + 1) * SCREEN_WIDTH, span);
+    } else {
+        memmove(SCREEN_RAM + (top + 1) * SCREEN_WIDTH, SCREEN_RAM + top * SCREEN_WIDTH, span);
+        memmove((uint8_t *)COLOR_RAM + (top + 1) * SCREEN_WIDTH, (uint8_t *)COLOR_RAM + top * SCREEN_WIDTH, span);
     }
+}
 
-    // Clear status bar
-    for (i = 0; i < sw; i++) {
-        cputc_at(i, 24, ' ', COL_CYAN);
+// Draw a full-width row of plain text, padded with spaces
+void draw_row_text(int y, const char *text, unsigned char color) {
+    char buf[81];
+    // Bit 7 reverses a character in 80-col mode - not wanted here
+    char keep = screen_mode == MODE_80COL ? 0x7F : 0xFF;
+    int i;
+
+    for (i = 0; i < screen_width && text[i]; i++) buf[i] = text[i] & keep;
+    for (; i < screen_width; i++) buf[i] = ' ';
+    buf[i] = '\0';
+
+    if (screen_mode == MODE_80COL) {
+        render_line_80(y, buf, screen_width, 0, 80, color, NULL);
+    } else {
+        cputs_at(0, y, buf, color);
     }
 }
 
@@ -258,33 +684,14 @@ void draw_cursor() {
     if (screen_y >= 1 && screen_y <= EDIT_HEIGHT) {
         if (screen_mode == MODE_80COL) {
             // In bitmap mode, draw cursor by inverting the character cell
-            // Use reverse-video effect: redraw char with inverted colors
-            int len = strlen(lines[cursor_y]);
-            char c = (cursor_x < len) ? lines[cursor_y][cursor_x] : ' ';
-            // Draw with black-on-white (inverted) by using a special approach
-            // In bitmap mode: XOR the bitmap bytes for this character position
-            uint8_t *bmp;
-            int cell_col = screen_x >> 1;
-            int side = screen_x & 1;
-            uint8_t xor_mask = (side == 0) ? 0xF0 : 0x0F;
-
-            bmp = BITMAP_BASE + (uint16_t)screen_y * 320 + (uint16_t)cell_col * 8;
-
             // Uses outer begin_draw from update_cursor (draw_depth > 0)
-            bmp[0] ^= xor_mask;
-            bmp[1] ^= xor_mask;
-            bmp[2] ^= xor_mask;
-            bmp[3] ^= xor_mask;
-            bmp[4] ^= xor_mask;
-            bmp[5] ^= xor_mask;
-            bmp[6] ^= xor_mask;
-            bmp[7] ^= xor_mask;
+            invert_cell(screen_x, screen_y);
         } else {
             int pos = screen_y * SCREEN_WIDTH + screen_x;
             int len = strlen(lines[cursor_y]);
 
             if (cursor_x < len) {
-                SCREEN_RAM[pos] = lines[cursor_y][cursor_x] + 128;
+                SCREEN_RAM[pos] = screen_codes[(unsigned char)lines[cursor_y][cursor_x]] | 0x80;
                 COLOR_RAM[pos] = COL_WHITE;
             } else {
                 SCREEN_RAM[pos] = CURSOR_CHAR;
@@ -294,50 +701,123 @@ void draw_cursor() {
     }
 }
 
-// Fast update: only redraws the current line + title bar position + cursor
-// Use for typing operations (insert/delete char) instead of full redraw
+// Typing update: redraws the current line from the edit point, or
+// everything below it when the edit split or joined lines
 void update_current_line(void) {
-    int screen_y = cursor_y - scroll_offset + 1;
-
-    if (screen_mode == MODE_80COL) screen80_begin_draw();
-
-    // Update position in title bar
-    {
-        char pos_info[15];
-        int global_line = current_page * LINES_PER_PAGE + cursor_y + 1;
-        sprintf(pos_info, " %d:%d  ", global_line, cursor_x + 1);
-        cputs_at(8, 0, pos_info, COL_GREEN);
-    }
-
-    // Redraw only the current line
-    if (screen_y >= 1 && screen_y <= EDIT_HEIGHT) {
-        if (screen_mode != MODE_80COL) {
-            draw_line_number(screen_y, cursor_y);
+    int lo;
+
+    if (shown_x >= 0 && cursor_y == shown_y && current_page == shown_page &&
+        scroll_offset == shown_scroll) {
+        lo = cursor_x < shown_x ? cursor_x : shown_x;
+        // A keyword can end at the edit point
+        while (basic_mode && lo > 0 &&
+               (isupper(lines[cursor_y][lo - 1]) || lines[cursor_y][lo - 1] == '$' ||
+                lines[cursor_y][lo - 1] == '%')) {
+            lo--;
+        }
+        // A source lexer's classes can change anywhere on the line: one
+        // keystroke turns a label into a mnemonic or opens a string
+        if (!basic_mode && syntax_lang != LANG_NONE) lo = 0;
+        // One past the end covers the cell a delete left behind
+        damage_span(cursor_y, lo, strlen(lines[cursor_y]) + 1);
+        // An opened or closed /* recolors everything below
+        if (hl_carry_changed(cursor_y)) {
+            damage_lines(cursor_y + 1, scroll_offset + EDIT_HEIGHT - 1);
         }
-        draw_text_line(screen_y, cursor_y);
+    } else if (shown_x >= 0) {
+        lo = cursor_y < shown_y ? cursor_y : shown_y;
+        damage_lines(lo, scroll_offset + EDIT_HEIGHT - 1);
     }
+    screen_schedule();
+}
 
-    draw_cursor();
+#ifdef WHISPER64_PROFILE
+// CIA 2 timer A counts cycles down from $FFFF, timer B counts its
+// underflows: together a 32-bit cycle counter
+static void profile_start(void) {
+    POKE(0xDD0E, 0);
+    POKE(0xDD0F, 0);
+    POKE(0xDD04, 0xFF);
+    POKE(0xDD05, 0xFF);
+    POKE(0xDD06, 0xFF);
+    POKE(0xDD07, 0xFF);
+    POKE(0xDD0F, 0x51);  // count timer A underflows, load, start
+    POKE(0xDD0E, 0x11);  // count cycles, load, start
+}
+
+static uint32_t profile_stop(void) {
+    uint16_t a, b;
 
-    if (screen_mode == MODE_80COL) screen80_end_draw();
+    volatile uint8_t *cia2 = (volatile uint8_t *)0xDD00;
+
+    cia2[0x0E] = 0;
+    a = cia2[0x04] | (cia2[0x05] << 8);
+    b = cia2[0x06] | (cia2[0x07] << 8);
+    return ((uint32_t)(0xFFFF - b) << 16 | (0xFFFF - a));
 }
+#endif
 
+// Full redraw, for changes too broad to track
 void update_cursor() {
-    if (mouse_is_enabled()) {
-        mouse_hide_cursor();
-    }
+#ifdef WHISPER64_PROFILE
+    char msg[40];
 
-    // Batch all bitmap + color writes under one ROM banking operation
-    if (screen_mode == MODE_80COL) screen80_begin_draw();
+    profile_start();
+#endif
 
-    redraw_screen();
-    draw_cursor();
+    damage_all();
+    screen_flush();
 
-    if (screen_mode == MODE_80COL) screen80_end_draw();
+#ifdef WHISPER64_PROFILE
+    // With an REU this includes the wait for the vertical blank
+    sprintf(msg, "REDRAW %lu CYCLES", profile_stop());
+    show_message(msg, COL_CYAN);
+#endif
+}
 
-    if (mouse_is_enabled()) {
-        mouse_draw_cursor();
+// Screen saved in the REU while a full-screen overlay is up
+static REUPtr snap_area;
+static unsigned char snap_valid;
+static unsigned char snap_mode;
+
+void screen_snapshot_init(void) {
+    snap_area = reu_reserve(SCREEN80_SNAP_BYTES);
+}
+
+void screen_modal_begin(void) {
+    snap_valid = 0;
+    if (snap_area == 0) return;
+
+    // The snapshot must match shown_* exactly
+    screen_flush();
+    if (mouse_is_enabled()) mouse_hide_cursor();
+
+    snap_mode = screen_mode;
+    if (screen_mode == MODE_80COL) {
+        screen80_snapshot(snap_area);
+    } else {
+        reu_write(snap_area, SCREEN_RAM, 1000);
+        reu_write(snap_area + 1000, (void *)COLOR_RAM, 1000);
+    }
+    snap_valid = 1;
+}
+
+void screen_modal_end(void) {
+    if (!snap_valid || snap_mode != screen_mode) {
+        update_cursor();
+        return;
+    }
+    snap_valid = 0;
+
+    if (screen_mode == MODE_80COL) {
+        screen80_restore(snap_area);
+    } else {
+        // 2000 bytes: done within the vertical blank
+        frame_wait();
+        reu_read(snap_area, SCREEN_RAM, 1000);
+        reu_read(snap_area + 1000, (void *)COLOR_RAM, 1000);
     }
+    if (mouse_is_enabled()) mouse_draw_cursor();
 }
 
 void show_message(const char *msg, unsigned char col) {
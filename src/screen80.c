@@ -1,6 +1,8 @@
 #include "screen80.h"
-#include "font_4x8.h"
+#include "font_tables.h"
 #include "editor_state.h"
+#include "reu.h"
+#include "frame.h"
 #include <string.h>
 
 // Saved VIC-II register state for restoring 40-col mode
@@ -13,14 +15,48 @@ static uint8_t saved_dd00;
 static uint8_t draw_depth = 0;
 static uint8_t saved_01;
 
+// RAM interrupt handlers (src/irq80.s), reached through the CPU vectors
+// under the KERNAL while drawing has the ROMs banked out
+extern uint8_t r80_irq_01;
+void r80_irq(void);
+void r80_nmi(void);
+
+// Inside a draw block: show I/O (color RAM, VIC, REU registers) with the
+// ROMs still out, then go back to RAM everywhere
+#define IO_IN()  POKE(0x01, (saved_01 & 0xF8) | 0x05)
+#define IO_OUT() POKE(0x01, saved_01 & 0xF8)
+
+// Which 80-column engine is drawing - see the character-pair engine below
+#define ENGINE_BITMAP 0
+#define ENGINE_PAIRS  1
+static uint8_t engine;
+
+// REU staging area for the blitter: a bitmap and a video matrix, then
+// the color RAM of whichever screen is hidden.
+// 0 without an REU, and the CPU does the work instead.
+#define BLIT_BITMAP_BYTES 8000
+#define BLIT_COLORS (BLIT_BITMAP_BYTES + 1000)
+#define BLIT_REU_BYTES (BLIT_COLORS + 1000)
+static REUPtr blit_area;
+
 void screen80_init(void) {
-    // Font is pre-built in font_4x8.h - no runtime init needed
+    blit_area = reu_reserve(BLIT_REU_BYTES);
+
+    // Writes under the KERNAL always reach RAM; these vectors only come
+    // into view once a draw banks the ROMs out. $FFFA is past the bitmap.
+    POKE(0xFFFA, (uint16_t)r80_nmi & 0xFF);
+    POKE(0xFFFB, (uint16_t)r80_nmi >> 8);
+    POKE(0xFFFE, (uint16_t)r80_irq & 0xFF);
+    POKE(0xFFFF, (uint16_t)r80_irq >> 8);
+    r80_irq_01 = PEEK(0x01);
 }
 
+// Interrupts stay on while drawing: the RAM handler banks the KERNAL in
+// for each IRQ, so keys typed during a long redraw are not lost
 void screen80_begin_draw(void) {
     if (draw_depth == 0) {
-        __asm__ volatile("sei");
         saved_01 = PEEK(0x01);
+        r80_irq_01 = saved_01;
         // Clear LORAM, HIRAM, CHAREN: pure RAM everywhere
         // $D000-$DFFF = RAM (so writes to $D800 go to DRAM, not color SRAM)
         // $E000-$FFFF = RAM (bitmap writable)
@@ -34,63 +70,513 @@ void screen80_end_draw(void) {
     draw_depth--;
     if (draw_depth == 0) {
         POKE(0x01, saved_01);
-        __asm__ volatile("cli");
     }
 }
 
+// Point the VIC at the current engine's screen. Needs I/O visible.
+// Bit 7 of $D011 reads as the raster line but writes the interrupt
+// line, so it is always written as 0 (see frame.h).
+static void vic_engine(void) {
+    if (engine == ENGINE_PAIRS) {
+        // $64: video matrix at $1800 in bank ($D800), charset at $1000 ($D000)
+        POKE(0xD018, 0x64);
+        POKE(0xD011, PEEK(0xD011) & 0x5F);
+    } else {
+        // $68: video matrix at $1800 in bank ($C000+$1800=$D800), bitmap at $2000 ($E000)
+        POKE(0xD018, 0x68);
+        POKE(0xD011, (PEEK(0xD011) & 0x7F) | 0x20);
+    }
+}
+
+// Both screens stay in memory while the other is shown: 40 columns at
+// $0400, 80 columns in VIC bank 3. Only color RAM is shared - the pair
+// engine takes its colors from there too - so the hidden screen's colors
+// are swapped out to the REU, or without one to the RAM under the CIAs.
+#define HIDDEN_COLORS ((uint8_t *)0xDC00)
+
+static uint8_t shown_before;   // the 80-column screen has been set up
+
+static void swap_colors(void) {
+    uint8_t shown[40], hidden[40];
+    uint8_t *sram, *ram;
+    uint8_t y;
+
+    if (blit_area) {
+        reu_swap(blit_area + BLIT_COLORS, (void *)0xD800, 1000);
+        return;
+    }
+
+    screen80_begin_draw();
+    for (y = 0; y < 25; y++) {
+        sram = (uint8_t *)0xD800 + y * 40;
+        ram = HIDDEN_COLORS + y * 40;
+        IO_IN();
+        memcpy(shown, sram, 40);
+        IO_OUT();
+        memcpy(hidden, ram, 40);
+        memcpy(ram, shown, 40);
+        IO_IN();
+        memcpy(sram, hidden, 40);
+        IO_OUT();
+    }
+    screen80_end_draw();
+}
+
+// Flip to the 80-column screen as it was left, in the vertical blank
 void screen80_enable(void) {
     saved_d018 = PEEK(0xD018);
     saved_d011 = PEEK(0xD011);
     saved_dd00 = PEEK(0xDD00);
 
+    frame_wait();
+    swap_colors();
     POKE(0xDD00, (PEEK(0xDD00) & 0xFC));
-    // $68: video matrix at $1800 in bank ($C000+$1800=$D800), bitmap at $2000 ($E000)
-    POKE(0xD018, 0x68);
-    POKE(0xD011, PEEK(0xD011) | 0x20);
     POKE(0xD020, 0);
     POKE(0xD021, 0);
-
     screen_mode = MODE_80COL;
-    clrscr_80();
 
+    if (shown_before) {
+        vic_engine();
+        return;
+    }
+    // Start with the pair engine; clrscr_80 sets the VIC up for it
+    shown_before = 1;
+    engine = ENGINE_PAIRS;
+    clrscr_80();
 }
 
 void screen80_disable(void) {
     while (draw_depth > 0) screen80_end_draw();
+
+    frame_wait();
     POKE(0xDD00, saved_dd00);
-    POKE(0xD011, saved_d011);
+    POKE(0xD011, saved_d011 & 0x7F);
     POKE(0xD018, saved_d018);
+    swap_colors();
     screen_mode = MODE_40COL;
 }
 
+// Run one armed REU transfer with RAM everywhere. The REU registers are
+// only visible with I/O banked in, so they are loaded first and the $FF00
+// write starts the DMA once $D800 and $E000 are plain RAM again.
+static void blit(uint8_t command, REUPtr reu_addr, uint8_t *c64_addr,
+                 uint16_t size, uint8_t control) {
+    screen80_begin_draw();
+    IO_IN();
+    reu_arm(command, reu_addr, c64_addr, size, control);
+    IO_OUT();
+    REU_TRIGGER();
+    __asm__ volatile("" ::: "memory");
+    screen80_end_draw();
+}
+
+// Fill size bytes at dst with value. With an REU the byte is stashed once
+// and fetched back with the REU address held still, one byte per cycle.
+void screen80_fill(uint8_t *dst, uint16_t size, uint8_t value) {
+    static uint8_t fill_byte;
+
+    if (blit_area == 0) {
+        // Must be inside banking block - $D800 writes need I/O banked out
+        // so they go to DRAM (not color SRAM)
+        screen80_begin_draw();
+        memset(dst, value, size);
+        screen80_end_draw();
+        return;
+    }
+
+    fill_byte = value;
+    blit(REU_CMD_ARM_STASH, blit_area, &fill_byte, 1, 0);
+    blit(REU_CMD_ARM_FETCH, blit_area, dst, size, REU_CTRL_FIX_REU);
+}
+
+// A character's glyph in font_lr, whatever its bit 7
+static const uint8_t *glyph(char c) {
+    uint8_t i = c & 0x7F;
+    return font_lr + (glyph_lo[i] | (glyph_page[i] << 8));
+}
+
+// What to EOR a glyph half with: bit 7 shows the character reversed
+static uint8_t reverse_mask(char c, uint8_t half) {
+    return (c & 0x80) ? half : 0;
+}
+
+// Character-pair engine. The VIC runs in text mode with a charset at
+// $D000 (RAM under I/O) that is built as the screen changes: each cell
+// shows one glyph made of its two characters. Glyphs live in 256 slots
+// found by a hash of the pair; slot 0 always holds two spaces. Typical
+// text needs far fewer than 256 pairs, and a changed cell is one screen
+// byte plus its color. When a screen needs more pairs than there are
+// slots, it is redrawn as a bitmap and the bitmap engine takes over
+// until the next clear.
+#define PAIR_CHARSET ((uint8_t *)0xD000)
+#define PAIR_REV     0x80    // key bit: character shown reversed, as in text
+
+static uint8_t slot_left[256];   // pair held by each slot, 0 = free
+static uint8_t slot_right[256];
+static uint8_t slot_next[256];   // hash chain, 0 = end
+static uint8_t slot_refs[256];   // cells showing the slot; 255 sticks
+static uint8_t bucket[256];      // first slot per hash, 0 = none
+static uint8_t clock_hand;       // where the search for a free slot resumes
+
+static uint8_t pair_key(char c) {
+    uint8_t k = c & 0x7F;
+    return (k < 32 ? ' ' : k) | (c & PAIR_REV);
+}
+
+static uint8_t pair_hash(uint8_t l, uint8_t r) {
+    return l ^ (r << 1) ^ (r >> 4);
+}
+
+static void pairs_reset(void) {
+    memset(slot_left, 0, sizeof(slot_left));
+    memset(slot_refs, 0, sizeof(slot_refs));
+    memset(bucket, 0, sizeof(bucket));
+    slot_left[0] = ' ';
+    slot_right[0] = ' ';
+    memset(PAIR_CHARSET, 0, 8);
+    clock_hand = 0;
+}
+
+static void slot_ref(uint8_t s) {
+    if (s && slot_refs[s] != 255) slot_refs[s]++;
+}
+
+static void slot_unref(uint8_t s) {
+    if (s && slot_refs[s] && slot_refs[s] != 255) slot_refs[s]--;
+}
+
+static void build_glyph(uint8_t s) {
+    const uint8_t *l = glyph(slot_left[s]);
+    const uint8_t *r = glyph(slot_right[s]) + FONT_RIGHT;
+    uint8_t *dst = PAIR_CHARSET + (uint16_t)s * 8;
+    uint8_t rev = reverse_mask(slot_left[s], 0xF0) | reverse_mask(slot_right[s], 0x0F);
+    uint8_t i;
+
+    for (i = 0; i < 8; i++) {
+        dst[i] = (l[i] | r[i]) ^ rev;
+    }
+}
+
+// Slot showing the pair l, r, building its glyph if it has none.
+// Returns -1 when every slot is on screen.
+static int pair_slot(uint8_t l, uint8_t r) {
+    uint8_t h, s, n;
+    uint8_t *link;
+
+    if (l == ' ' && r == ' ') return 0;
+
+    h = pair_hash(l, r);
+    for (s = bucket[h]; s; s = slot_next[s]) {
+        if (slot_left[s] == l && slot_right[s] == r) return s;
+    }
+
+    // Take the next slot no cell shows, dropping the pair it cached
+    for (n = 255; n; n--) {
+        if (++clock_hand == 0) clock_hand = 1;
+        if (slot_refs[clock_hand] == 0) break;
+    }
+    if (n == 0) return -1;
+    s = clock_hand;
+
+    if (slot_left[s]) {
+        link = &bucket[pair_hash(slot_left[s], slot_right[s])];
+        while (*link != s) link = &slot_next[*link];
+        *link = slot_next[s];
+    }
+
+    slot_left[s] = l;
+    slot_right[s] = r;
+    slot_next[s] = bucket[h];
+    bucket[h] = s;
+    build_glyph(s);
+    return s;
+}
+
+// Show pair l, r in a matrix cell. Returns 0 if no slot was free.
+static uint8_t pair_put(uint8_t *cell, uint8_t l, uint8_t r) {
+    int s = pair_slot(l, r);
+
+    if (s < 0) return 0;
+    if (*cell != s) {
+        slot_unref(*cell);
+        slot_ref(s);
+        *cell = s;
+    }
+    return 1;
+}
+
+// Out of slots: draw the screen as a bitmap from the pairs its cells
+// show, and let the bitmap engine carry on. Called inside a draw block.
+static void pairs_to_bitmap(void) {
+    char text[80];
+    uint8_t colors[40];
+    uint8_t *row;
+    uint8_t y, c, s;
+
+    for (y = 0; y < 25; y++) {
+        row = MATRIX_ROW(y);
+        for (c = 0; c < 40; c++) {
+            s = row[c];
+            text[c * 2] = slot_left[s];
+            text[c * 2 + 1] = slot_right[s];
+        }
+
+        IO_IN();
+        memcpy(colors, row, 40);
+        IO_OUT();
+
+        r80_src = text;
+        r80_dst = BITMAP_ROW(y);
+        r80_col = 0;
+        r80_end = 80;
+        r80_cells();
+
+        for (c = 0; c < 40; c++) {
+            row[c] = (colors[c] & 0x0F) << 4;
+        }
+    }
+
+    engine = ENGINE_BITMAP;
+    IO_IN();
+    vic_engine();
+    IO_OUT();
+}
+
+// Move text rows top..bottom one row up (dir > 0) or down (dir < 0),
+// bitmap and video matrix. The REU can't copy C64 to C64, so the rows
+// go out to the staging area and come back one row further on.
+void screen80_move_rows(int top, int bottom, signed char dir) {
+    int src = dir > 0 ? top + 1 : top;
+    int dst = dir > 0 ? top : top + 1;
+    uint16_t span = bottom - top;
+
+    if (bottom <= top) return;
+
+    if (engine == ENGINE_PAIRS) {
+        uint8_t *row;
+        uint8_t i;
+
+        screen80_begin_draw();
+        // The row moved over loses its references, the row left behind
+        // now shows its pairs twice
+        row = MATRIX_ROW(dir > 0 ? top : bottom);
+        for (i = 0; i < 40; i++) slot_unref(row[i]);
+        memmove(MATRIX_ROW(dst), MATRIX_ROW(src), span * 40);
+        row = MATRIX_ROW(dir > 0 ? bottom : top);
+        for (i = 0; i < 40; i++) slot_ref(row[i]);
+
+        IO_IN();
+        memmove(MATRIX_ROW(dst), MATRIX_ROW(src), span * 40);
+        IO_OUT();
+        screen80_end_draw();
+        return;
+    }
+
+    if (blit_area == 0) {
+        screen80_begin_draw();
+        memmove(BITMAP_BASE + dst * 320, BITMAP_BASE + src * 320, span * 320);
+        memmove(SCREEN_RAM_80 + dst * 40, SCREEN_RAM_80 + src * 40, span * 40);
+        screen80_end_draw();
+        return;
+    }
+
+    blit(REU_CMD_ARM_STASH, blit_area, BITMAP_BASE + src * 320, span * 320, 0);
+    blit(REU_CMD_ARM_FETCH, blit_area, BITMAP_BASE + dst * 320, span * 320, 0);
+    blit(REU_CMD_ARM_STASH, blit_area + BLIT_BITMAP_BYTES, SCREEN_RAM_80 + src * 40, span * 40, 0);
+    blit(REU_CMD_ARM_FETCH, blit_area + BLIT_BITMAP_BYTES, SCREEN_RAM_80 + dst * 40, span * 40, 0);
+}
+
+// Frames: a heavy redraw goes to a back buffer in the REU staging area
+// and reaches the screen in one DMA during the vertical blank. There is
+// no free RAM for a second bitmap, so rows are drawn in a one-row window
+// that is swapped with the back buffer as drawing moves between rows.
+// Row moves share the staging area and must not happen inside a frame.
+static uint8_t frame_active;
+static int frame_row;                // row held in the window, -1 if none
+static int frame_first, frame_last;  // rows drawn this frame
+static uint8_t frame_bmp[320];
+static uint8_t frame_matrix[40];
+
+static void frame_put_row(void) {
+    if (frame_row < 0) return;
+    blit(REU_CMD_ARM_STASH, blit_area + (uint16_t)frame_row * 320, frame_bmp, 320, 0);
+    blit(REU_CMD_ARM_STASH, blit_area + BLIT_BITMAP_BYTES + frame_row * 40,
+         frame_matrix, 40, 0);
+}
+
+// Bitmap and video matrix of row y: on screen, or in the window
+static uint8_t *target_row(int y, uint8_t **matrix) {
+    if (!frame_active) {
+        *matrix = MATRIX_ROW(y);
+        return BITMAP_ROW(y);
+    }
+
+    if (y != frame_row) {
+        frame_put_row();
+        blit(REU_CMD_ARM_FETCH, blit_area + (uint16_t)y * 320, frame_bmp, 320, 0);
+        blit(REU_CMD_ARM_FETCH, blit_area + BLIT_BITMAP_BYTES + y * 40,
+             frame_matrix, 40, 0);
+        frame_row = y;
+        if (y < frame_first) frame_first = y;
+        if (y > frame_last) frame_last = y;
+    }
+    *matrix = frame_matrix;
+    return frame_bmp;
+}
+
+void screen80_frame_begin(void) {
+    // Text mode changes a byte per cell - nothing to tear
+    if (blit_area == 0 || frame_active || engine == ENGINE_PAIRS) return;
+
+    // Rows the frame leaves alone must come through unchanged
+    blit(REU_CMD_ARM_STASH, blit_area, BITMAP_BASE, BLIT_BITMAP_BYTES, 0);
+    blit(REU_CMD_ARM_STASH, blit_area + BLIT_BITMAP_BYTES, SCREEN_RAM_80, 1000, 0);
+
+    frame_active = 1;
+    frame_row = -1;
+    frame_first = 25;
+    frame_last = -1;
+}
+
+void screen80_frame_end(void) {
+    uint16_t first, rows;
+
+    if (!frame_active) return;
+    frame_put_row();
+    frame_active = 0;
+    if (frame_last < frame_first) return;
+
+    first = frame_first;
+    rows = frame_last - frame_first + 1;
+
+    // Start in the lower border. A 320-byte row copies in about 5 raster
+    // lines and is displayed over 8, so the copy stays ahead of the beam.
+    frame_wait();
+    screen80_begin_draw();
+
+    // Colors first - they are shorter and the top rows need them soonest
+    blit(REU_CMD_ARM_FETCH, blit_area + BLIT_BITMAP_BYTES + first * 40,
+         SCREEN_RAM_80 + first * 40, rows * 40, 0);
+    blit(REU_CMD_ARM_FETCH, blit_area + first * 320,
+         BITMAP_BASE + first * 320, rows * 320, 0);
+    screen80_end_draw();
+}
+
+// Screen snapshots. The pair engine's screen is its charset, video
+// matrix and color RAM plus the slot tables that describe them; the
+// bitmap engine's is the bitmap and video matrix.
+#define SNAP_MATRIX 8000
+#define SNAP_COLORS 9000
+#define SNAP_TABLES 10000
+
+static uint8_t snap_engine;
+
+void screen80_snapshot(REUPtr area) {
+    snap_engine = engine;
+    if (engine == ENGINE_PAIRS) {
+        blit(REU_CMD_ARM_STASH, area, PAIR_CHARSET, 2048, 0);
+        reu_write(area + SNAP_COLORS, (void *)0xD800, 1000);
+        reu_write(area + SNAP_TABLES, slot_left, 256);
+        reu_write(area + SNAP_TABLES + 256, slot_right, 256);
+        reu_write(area + SNAP_TABLES + 512, slot_next, 256);
+        reu_write(area + SNAP_TABLES + 768, slot_refs, 256);
+        reu_write(area + SNAP_TABLES + 1024, bucket, 256);
+    } else {
+        blit(REU_CMD_ARM_STASH, area, BITMAP_BASE, BLIT_BITMAP_BYTES, 0);
+    }
+    blit(REU_CMD_ARM_STASH, area + SNAP_MATRIX, SCREEN_RAM_80, 1000, 0);
+}
+
+void screen80_restore(REUPtr area) {
+    while (frame_active) screen80_frame_end();
+
+    if (snap_engine == ENGINE_PAIRS) {
+        reu_read(area + SNAP_TABLES, slot_left, 256);
+        reu_read(area + SNAP_TABLES + 256, slot_right, 256);
+        reu_read(area + SNAP_TABLES + 512, slot_next, 256);
+        reu_read(area + SNAP_TABLES + 768, slot_refs, 256);
+        reu_read(area + SNAP_TABLES + 1024, bucket, 256);
+        clock_hand = 0;
+    }
+
+    // About 4000 bytes for the pair engine, which fit in the vertical
+    // blank; the bitmap goes last and stays ahead of the beam
+    frame_wait();
+    blit(REU_CMD_ARM_FETCH, area + SNAP_MATRIX, SCREEN_RAM_80, 1000, 0);
+    if (snap_engine == ENGINE_PAIRS) {
+        blit(REU_CMD_ARM_FETCH, area, PAIR_CHARSET, 2048, 0);
+        reu_read(area + SNAP_COLORS, (void *)0xD800, 1000);
+    } else {
+        blit(REU_CMD_ARM_FETCH, area, BITMAP_BASE, BLIT_BITMAP_BYTES, 0);
+    }
+    if (engine != snap_engine) {
+        engine = snap_engine;
+        vic_engine();
+    }
+}
+
+// Reverse one character cell in place
+void invert_cell_80(int x, int y) {
+    uint8_t *bmp, *matrix;
+    uint8_t xor_mask = (x & 1) ? 0x0F : 0xF0;
+
+    screen80_begin_draw();
+
+    if (engine == ENGINE_PAIRS) {
+        // Same pair with one side reversed
+        uint8_t *cell = MATRIX_ROW(y) + (x >> 1);
+        uint8_t l = slot_left[*cell], r = slot_right[*cell];
+
+        if (x & 1) r ^= PAIR_REV; else l ^= PAIR_REV;
+        if (pair_put(cell, l, r)) {
+            screen80_end_draw();
+            return;
+        }
+        pairs_to_bitmap();
+    }
+
+    bmp = target_row(y, &matrix) + (uint16_t)(x >> 1) * 8;
+    bmp[0] ^= xor_mask;
+    bmp[1] ^= xor_mask;
+    bmp[2] ^= xor_mask;
+    bmp[3] ^= xor_mask;
+    bmp[4] ^= xor_mask;
+    bmp[5] ^= xor_mask;
+    bmp[6] ^= xor_mask;
+    bmp[7] ^= xor_mask;
+    screen80_end_draw();
+}
+
+// A clear screen needs only the blank pair, so it is also where a
+// bitmap fallback goes back to the pair engine
 void clrscr_80(void) {
-    // Must be inside banking block - $D800 writes need I/O banked out
-    // so they go to DRAM (not color SRAM)
+    while (frame_active) screen80_frame_end();
+
+    engine = ENGINE_PAIRS;
     screen80_begin_draw();
-    memset(BITMAP_BASE, 0, 8000);
-    memset(SCREEN_RAM_80, 0x10, 1000);
+    pairs_reset();
+    screen80_fill(SCREEN_RAM_80, 1000, 0);
+    IO_IN();
+    memset(SCREEN_RAM_80, COL_WHITE, 1000);
+    vic_engine();
+    IO_OUT();
     screen80_end_draw();
 }
 
-// Core character renderer - draws one 4px-wide character into the bitmap
-// Call screen80_begin_draw() before and screen80_end_draw() after batch rendering
+// Draw one character: the pair engine swaps one side of the cell's
+// pair, the bitmap engine writes its half of the cell. Batches go
+// between screen80_begin_draw() and screen80_end_draw().
 void cputc_at_80(int x, int y, char c, uint8_t color) {
-    int cell_col, side;
-    uint8_t *bmp;
+    int cell_col;
+    uint8_t *bmp, *matrix;
     const uint8_t *fnt;
-    int font_idx;
+    uint8_t rev;
     uint8_t need_end = 0;
 
     if (x < 0 || x >= 80 || y < 0 || y >= 25) return;
 
     cell_col = x >> 1;
-    side = x & 1;
-
-    font_idx = (uint8_t)c - 32;
-    if (font_idx < 0 || font_idx >= 96) font_idx = 0;
-    fnt = &font_4x8[font_idx * 8];
-
-    bmp = BITMAP_BASE + (uint16_t)y * 320 + (uint16_t)cell_col * 8;
+    fnt = glyph(c);
 
     // If not already in draw mode, enter it for this single char
     if (draw_depth == 0) {
@@ -98,98 +584,165 @@ void cputc_at_80(int x, int y, char c, uint8_t color) {
         need_end = 1;
     }
 
+    if (engine == ENGINE_PAIRS) {
+        // Replace one side of the cell's pair
+        uint8_t *cell = MATRIX_ROW(y) + cell_col;
+        uint8_t l = slot_left[*cell], r = slot_right[*cell];
+
+        if (x & 1) r = pair_key(c); else l = pair_key(c);
+        if (pair_put(cell, l, r)) {
+            IO_IN();
+            *cell = color;
+            IO_OUT();
+            if (need_end) screen80_end_draw();
+            return;
+        }
+        pairs_to_bitmap();
+    }
+
+    bmp = target_row(y, &matrix) + (uint16_t)cell_col * 8;
+
     // Set color - must be inside banking block so write goes to DRAM at $D800
-    SCREEN_RAM_80[y * 40 + cell_col] = (color << 4);
-
-    if (side == 0) {
-        bmp[0] = (bmp[0] & 0x0F) | (fnt[0] & 0xF0);
-        bmp[1] = (bmp[1] & 0x0F) | (fnt[1] & 0xF0);
-        bmp[2] = (bmp[2] & 0x0F) | (fnt[2] & 0xF0);
-        bmp[3] = (bmp[3] & 0x0F) | (fnt[3] & 0xF0);
-        bmp[4] = (bmp[4] & 0x0F) | (fnt[4] & 0xF0);
-        bmp[5] = (bmp[5] & 0x0F) | (fnt[5] & 0xF0);
-        bmp[6] = (bmp[6] & 0x0F) | (fnt[6] & 0xF0);
-        bmp[7] = (bmp[7] & 0x0F) | (fnt[7] & 0xF0);
+    matrix[cell_col] = (color << 4);
+
+    // The other half of the cell belongs to the neighbour - keep it
+    if ((x & 1) == 0) {
+        rev = reverse_mask(c, 0xF0);
+        bmp[0] = (bmp[0] & 0x0F) | (fnt[0] ^ rev);
+        bmp[1] = (bmp[1] & 0x0F) | (fnt[1] ^ rev);
+        bmp[2] = (bmp[2] & 0x0F) | (fnt[2] ^ rev);
+        bmp[3] = (bmp[3] & 0x0F) | (fnt[3] ^ rev);
+        bmp[4] = (bmp[4] & 0x0F) | (fnt[4] ^ rev);
+        bmp[5] = (bmp[5] & 0x0F) | (fnt[5] ^ rev);
+        bmp[6] = (bmp[6] & 0x0F) | (fnt[6] ^ rev);
+        bmp[7] = (bmp[7] & 0x0F) | (fnt[7] ^ rev);
     } else {
-        bmp[0] = (bmp[0] & 0xF0) | (fnt[0] >> 4);
-        bmp[1] = (bmp[1] & 0xF0) | (fnt[1] >> 4);
-        bmp[2] = (bmp[2] & 0xF0) | (fnt[2] >> 4);
-        bmp[3] = (bmp[3] & 0xF0) | (fnt[3] >> 4);
-        bmp[4] = (bmp[4] & 0xF0) | (fnt[4] >> 4);
-        bmp[5] = (bmp[5] & 0xF0) | (fnt[5] >> 4);
-        bmp[6] = (bmp[6] & 0xF0) | (fnt[6] >> 4);
-        bmp[7] = (bmp[7] & 0xF0) | (fnt[7] >> 4);
+        fnt += FONT_RIGHT;
+        rev = reverse_mask(c, 0x0F);
+        bmp[0] = (bmp[0] & 0xF0) | (fnt[0] ^ rev);
+        bmp[1] = (bmp[1] & 0xF0) | (fnt[1] ^ rev);
+        bmp[2] = (bmp[2] & 0xF0) | (fnt[2] ^ rev);
+        bmp[3] = (bmp[3] & 0xF0) | (fnt[3] ^ rev);
+        bmp[4] = (bmp[4] & 0xF0) | (fnt[4] ^ rev);
+        bmp[5] = (bmp[5] & 0xF0) | (fnt[5] ^ rev);
+        bmp[6] = (bmp[6] & 0xF0) | (fnt[6] ^ rev);
+        bmp[7] = (bmp[7] & 0xF0) | (fnt[7] ^ rev);
     }
 
     if (need_end) screen80_end_draw();
 }
 
+// Whole cells inside the string go through the row kernel; only a half
+// cell at either end needs the read-modify-write of cputc_at_80
 void cputs_at_80(int x, int y, const char *s, uint8_t color) {
+    int len = strlen(s);
+    uint8_t *bmp, *matrix;
+
+    if (x < 0 || x >= 80 || y < 0 || y >= 25) return;
+    if (len > 80 - x) len = 80 - x;
+
     screen80_begin_draw();
-    while (*s && x < 80) {
-        cputc_at_80(x, y, *s, color);
-        s++;
-        x++;
+
+    if ((x & 1) && len > 0) {
+        cputc_at_80(x++, y, *s++, color);
+        len--;
+    }
+
+    if (engine == ENGINE_PAIRS) {
+        // One pair per whole cell
+        uint8_t *row = MATRIX_ROW(y);
+
+        while (len >= 2 && pair_put(row + (x >> 1), pair_key(s[0]), pair_key(s[1]))) {
+            IO_IN();
+            row[x >> 1] = color;
+            IO_OUT();
+            x += 2;
+            s += 2;
+            len -= 2;
+        }
+        if (len >= 2) pairs_to_bitmap();
+    }
+
+    if (len >= 2) {
+        bmp = target_row(y, &matrix);
+        memset(matrix + (x >> 1), color << 4, len >> 1);
+        r80_src = s - x;
+        r80_dst = bmp + (x >> 1) * 8;
+        r80_col = x;
+        r80_end = x + (len & ~1);
+        r80_cells();
+        s += len & ~1;
+        x += len & ~1;
+        len &= 1;
     }
+
+    if (len > 0) cputc_at_80(x, y, *s, color);
+
     screen80_end_draw();
 }
 
-// Fast bulk renderer: draw an entire screen row (all 80 columns) into bitmap
+// Fast bulk renderer: draw columns start_col..start_col+num_cols-1 of a row
 // Caller must pass a pre-built 80-char buffer (line number + text + padding)
-// Always cell-aligned for maximum speed - no per-char function calls
+// Widened to whole cells and drawn by the row kernel in render80.s
 void render_line_80(int screen_row, const char *buf, int buf_len,
-                    int start_col, int num_cols, uint8_t color) {
+                    int start_col, int num_cols, uint8_t color,
+                    const uint8_t *cell_colors) {
+    static char padded[80];
     uint8_t *bmp;
     uint8_t *col_row;
-    int cell;
-    const uint8_t *lfnt, *rfnt;
-    uint8_t colbyte;
-    int fi;
-
-    // Set color for this row
-    col_row = SCREEN_RAM_80 + (uint16_t)screen_row * 40;
-    colbyte = color << 4;
+    int cell, last_cell;
+
+    // Cells holding the span (80 columns / 2 chars per cell)
+    cell = start_col >> 1;
+    last_cell = (start_col + num_cols + 1) >> 1;
+    if (last_cell > 40) last_cell = 40;
+    if (cell >= last_cell) return;
+
+    // The kernel reads whole pairs - pad a short buffer with spaces
+    if (buf_len < last_cell * 2) {
+        memcpy(padded, buf, buf_len);
+        memset(padded + buf_len, ' ', 80 - buf_len);
+        buf = padded;
+    }
 
     // Ensure ROM is banked out for bitmap writes
     screen80_begin_draw();
 
-    // Pre-calculate row bitmap pointer
-    bmp = BITMAP_BASE + (uint16_t)screen_row * 320;
-
-    // Process all 40 cells (80 columns / 2 chars per cell)
-    for (cell = 0; cell < 40; cell++) {
-        int col = cell * 2;
-        char lc, rc;
-
-        // Get left and right characters from buffer
-        lc = (col < buf_len) ? buf[col] : ' ';
-        rc = (col + 1 < buf_len) ? buf[col + 1] : ' ';
-
-        // Font lookup - left char
-        fi = (uint8_t)lc - 32;
-        if (fi >= 96) fi = 0;
-        lfnt = &font_4x8[fi * 8];
-
-        // Font lookup - right char
-        fi = (uint8_t)rc - 32;
-        if (fi >= 96) fi = 0;
-        rfnt = &font_4x8[fi * 8];
-
-        // Set color for this cell
-        col_row[cell] = colbyte;
-
-        // Write both chars at once - no read-modify-write needed
-        bmp[0] = (lfnt[0] & 0xF0) | (rfnt[0] >> 4);
-        bmp[1] = (lfnt[1] & 0xF0) | (rfnt[1] >> 4);
-        bmp[2] = (lfnt[2] & 0xF0) | (rfnt[2] >> 4);
-        bmp[3] = (lfnt[3] & 0xF0) | (rfnt[3] >> 4);
-        bmp[4] = (lfnt[4] & 0xF0) | (rfnt[4] >> 4);
-        bmp[5] = (lfnt[5] & 0xF0) | (rfnt[5] >> 4);
-        bmp[6] = (lfnt[6] & 0xF0) | (rfnt[6] >> 4);
-        bmp[7] = (lfnt[7] & 0xF0) | (rfnt[7] >> 4);
+    if (engine == ENGINE_PAIRS) {
+        uint8_t *row = MATRIX_ROW(screen_row);
+        int c;
+
+        for (c = cell; c < last_cell; c++) {
+            if (!pair_put(row + c, pair_key(buf[c * 2]), pair_key(buf[c * 2 + 1]))) break;
+        }
+        if (c == last_cell) {
+            IO_IN();
+            if (cell_colors) {
+                memcpy(row + cell, cell_colors + cell, last_cell - cell);
+            } else {
+                memset(row + cell, color, last_cell - cell);
+            }
+            IO_OUT();
+            screen80_end_draw();
+            return;
+        }
+        // Out of slots - the rest of the row is drawn into the bitmap
+        pairs_to_bitmap();
+    }
 
-        bmp += 8;
+    bmp = target_row(screen_row, &col_row);
+    if (cell_colors) {
+        int c;
+        for (c = cell; c < last_cell; c++) col_row[c] = cell_colors[c] << 4;
+    } else {
+        memset(col_row + cell, color << 4, last_cell - cell);
     }
 
+    r80_src = buf;
+    r80_dst = bmp + (uint16_t)cell * 8;
+    r80_col = cell * 2;
+    r80_end = last_cell * 2;
+    r80_cells();
+
     screen80_end_draw();
 }
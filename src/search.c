@@ -1,6 +1,7 @@
 #include "search.h"
 #include "editor_state.h"
 #include "screen.h"
+#include "highlight.h"
 
 void search_next() {
     int i;
@@ -24,7 +25,7 @@ void search_next() {
                 scroll_offset = cursor_y - EDIT_HEIGHT + 1;
             }
             
-            update_cursor();
+            screen_flush();
             show_message("FOUND", COL_GREEN);
             return;
         }
@@ -43,7 +44,7 @@ void search_next() {
                 scroll_offset = cursor_y;
             }
             
-            update_cursor();
+            screen_flush();
             show_message("FOUND (WRAPPED)", COL_GREEN);
             return;
         }
@@ -127,6 +128,7 @@ void find_and_replace() {
                     memcpy(found, replace_term, replace_len);
                     replace_count++;
                     page_modified = 1;
+                    hl_line_changed(i);
                 }
             }
         }
@@ -0,0 +1,171 @@
+#include "spill.h"
+#include "editor_state.h"
+#include "screen.h"
+#include "drive.h"
+
+// Pages are packed as lines joined by CR, the temp file format, and
+// queued back to back in a ring. Pages bigger than the whole buffer are
+// rare and fall back to a direct write.
+#define SPILL_SIZE 2048
+#define SPILL_PAGES 4
+
+// Bytes sent per main loop pass - about 30ms on a stock 1541
+#define SPILL_CHUNK 32
+
+// Kernal keyboard buffer length
+#define KEY_COUNT (*(volatile unsigned char *)0xC6)
+
+typedef struct {
+    int page;
+    int start, len;       // where the packed page sits in spill_buf
+} SpillEntry;
+
+static char spill_buf[SPILL_SIZE];
+static SpillEntry queue[SPILL_PAGES];
+static unsigned char queue_head, queue_count;
+static int spill_pos;     // bytes of the head entry already sent
+static unsigned char spill_open, spill_drive;
+
+static void spill_step(void);
+
+static SpillEntry *queued(unsigned char i) {
+    return &queue[(queue_head + i) % SPILL_PAGES];
+}
+
+// Where n more bytes fit in the ring after the newest entry, or -1
+static int spill_room(int n) {
+    SpillEntry *last;
+    int head, tail;
+
+    if (queue_count == SPILL_PAGES) return -1;
+    if (queue_count == 0) return 0;
+
+    head = queued(0)->start;
+    last = queued(queue_count - 1);
+    tail = last->start + last->len;
+    if (last->start >= head) {
+        // Free space after the newest entry, and before the oldest
+        if (tail + n <= SPILL_SIZE) return tail;
+        return n <= head ? 0 : -1;
+    }
+    // Wrapped: free space only between the newest and the oldest
+    return tail + n <= head ? tail : -1;
+}
+
+unsigned char spill_queue(int page_num) {
+    SpillEntry *e;
+    int i, len, n = 0, at;
+
+    for (i = 0; i < num_lines; i++) {
+        n += strlen(lines[i]) + 1;
+    }
+    if (n > 0) n--;
+
+    // Too big for the ring: the direct write must not be overtaken by
+    // an older copy of the page still waiting here
+    if (n > SPILL_SIZE) {
+        spill_flush();
+        return 0;
+    }
+
+    // Only a full ring makes the page turn wait for the drive
+    while ((at = spill_room(n)) < 0) {
+        spill_step();
+    }
+
+    e = &queue[(queue_head + queue_count) % SPILL_PAGES];
+    e->page = page_num;
+    e->start = at;
+    e->len = n;
+    for (i = 0; i < num_lines; i++) {
+        len = strlen(lines[i]);
+        memcpy(spill_buf + at, lines[i], len);
+        at += len;
+        if (i < num_lines - 1) spill_buf[at++] = 13;
+    }
+
+    queue_count++;
+    spill_drive = current_drive;
+    return 1;
+}
+
+// Drop the head entry once it is written, or could not be
+static void spill_next(void) {
+    queue_head = (queue_head + 1) % SPILL_PAGES;
+    queue_count--;
+    spill_pos = 0;
+}
+
+static void spill_step(void) {
+    SpillEntry *e = queued(0);
+    char temp_name[20];
+    int end;
+
+    if (!spill_open) {
+        sprintf(temp_name, "@0:%s.P%d,S,W", TEMP_FILE, e->page);
+        drive_changed(spill_drive);
+        cbm_k_setlfs(SPILL_LFN, spill_drive, SPILL_LFN);
+        cbm_k_setnam(temp_name);
+        if (cbm_k_open() != 0) {
+            cbm_k_close(SPILL_LFN);
+            spill_next();
+            show_message("TEMP WRITE ERROR", COL_RED);
+            return;
+        }
+        spill_open = 1;
+    }
+
+    end = spill_pos + SPILL_CHUNK;
+    if (end > e->len) end = e->len;
+
+    cbm_k_chkout(SPILL_LFN);
+    while (spill_pos < end) {
+        cbm_k_chrout(spill_buf[e->start + spill_pos++]);
+    }
+    cbm_k_clrch();
+
+    // The drive commits the last sector on its own after CLOSE
+    if (spill_pos >= e->len) {
+        cbm_k_close(SPILL_LFN);
+        spill_open = 0;
+        spill_next();
+    }
+}
+
+void spill_pump(void) {
+    if (queue_count == 0 || KEY_COUNT) return;
+    spill_step();
+}
+
+void spill_flush(void) {
+    while (queue_count) {
+        spill_step();
+    }
+}
+
+int spill_read(int page_num) {
+    SpillEntry *e = 0;
+    int i = 0, pos = 0, k;
+    unsigned char q;
+
+    // The newest copy wins if the page was queued more than once
+    for (q = queue_count; q > 0; q--) {
+        if (queued(q - 1)->page == page_num) {
+            e = queued(q - 1);
+            break;
+        }
+    }
+    if (!e) return 0;
+
+    for (k = e->start; k < e->start + e->len; k++) {
+        if (spill_buf[k] == 13) {
+            lines[i][pos] = '\0';
+            i++;
+            pos = 0;
+        } else if (pos < MAX_LINE_LENGTH - 1) {
+            lines[i][pos++] = spill_buf[k];
+        }
+    }
+    lines[i][pos] = '\0';
+    return i + 1;
+}
@@ -1,26 +1,26 @@
 #include "undo.h"
 #include "editor_state.h"
 #include "screen.h"
+#include "highlight.h"
 
 // Undo state storage - 1 lines (maybe on C128)
 #define UNDO_LINES 1
 
-static char undo_lines[UNDO_LINES][MAX_LINE_LENGTH];
-static int undo_num_lines = 0;
-static int undo_cursor_x = 0;
-static int undo_cursor_y = 0;
-static int undo_scroll_offset = 0;
-static int undo_start_line = 0;
-static int undo_available = 0;
+typedef struct {
+    char lines[UNDO_LINES][MAX_LINE_LENGTH];
+    int num_lines;
+    int cursor_x;
+    int cursor_y;
+    int scroll_offset;
+    int start_line;
+    int available;
+} UndoSnapshot;
 
-// Redo state storage
-static char redo_lines[UNDO_LINES][MAX_LINE_LENGTH];
-static int redo_num_lines = 0;
-static int redo_cursor_x = 0;
-static int redo_cursor_y = 0;
-static int redo_scroll_offset = 0;
-static int redo_start_line = 0;
-static int redo_available = 0;
+// Undo and redo kept together so a document switch can move them as one block
+static struct {
+    UndoSnapshot undo;
+    UndoSnapshot redo;
+} history;
 
 void save_undo_state(void) {
     int i;
@@ -39,24 +39,24 @@ void save_undo_state(void) {
     
     // Copy relevant lines to undo buffer
     for (i = 0; i < lines_to_save && i < UNDO_LINES; i++) {
-        strcpy(undo_lines[i], lines[start_line + i]);
+        strcpy(history.undo.lines[i], lines[start_line + i]);
     }
     
-    undo_num_lines = num_lines;
-    undo_cursor_x = cursor_x;
-    undo_cursor_y = cursor_y;
-    undo_scroll_offset = scroll_offset;
-    undo_start_line = start_line;
-    undo_available = 1;
+    history.undo.num_lines = num_lines;
+    history.undo.cursor_x = cursor_x;
+    history.undo.cursor_y = cursor_y;
+    history.undo.scroll_offset = scroll_offset;
+    history.undo.start_line = start_line;
+    history.undo.available = 1;
     
     // Clear redo when new action happens
-    redo_available = 0;
+    history.redo.available = 0;
 }
 
 void undo_last_action(void) {
     int i;
     
-    if (!undo_available) {
+    if (!history.undo.available) {
         show_message("NOTHING TO UNDO", COL_RED);
         return;
     }
@@ -74,26 +74,27 @@ void undo_last_action(void) {
     
     // Save current state to redo buffer
     for (i = 0; i < lines_to_save && i < UNDO_LINES; i++) {
-        strcpy(redo_lines[i], lines[start_line + i]);
+        strcpy(history.redo.lines[i], lines[start_line + i]);
     }
-    redo_num_lines = num_lines;
-    redo_cursor_x = cursor_x;
-    redo_cursor_y = cursor_y;
-    redo_scroll_offset = scroll_offset;
-    redo_start_line = start_line;
-    redo_available = 1;
+    history.redo.num_lines = num_lines;
+    history.redo.cursor_x = cursor_x;
+    history.redo.cursor_y = cursor_y;
+    history.redo.scroll_offset = scroll_offset;
+    history.redo.start_line = start_line;
+    history.redo.available = 1;
     
     // Restore from undo buffer
-    for (i = 0; i < UNDO_LINES && undo_start_line + i < num_lines; i++) {
-        strcpy(lines[undo_start_line + i], undo_lines[i]);
+    for (i = 0; i < UNDO_LINES && history.undo.start_line + i < num_lines; i++) {
+        strcpy(lines[history.undo.start_line + i], history.undo.lines[i]);
     }
     
-    num_lines = undo_num_lines;
-    cursor_x = undo_cursor_x;
-    cursor_y = undo_cursor_y;
-    scroll_offset = undo_scroll_offset;
+    num_lines = history.undo.num_lines;
+    cursor_x = history.undo.cursor_x;
+    cursor_y = history.undo.cursor_y;
+    scroll_offset = history.undo.scroll_offset;
     
     page_modified = 1;
+    hl_invalidate_all();
     update_cursor();
     show_message("UNDONE", COL_GREEN);
 }
@@ -101,30 +102,40 @@ void undo_last_action(void) {
 void redo_last_action(void) {
     int i;
     
-    if (!redo_available) {
+    if (!history.redo.available) {
         show_message("NOTHING TO REDO", COL_RED);
         return;
     }
     
     // Restore from redo buffer
-    for (i = 0; i < UNDO_LINES && redo_start_line + i < num_lines; i++) {
-        strcpy(lines[redo_start_line + i], redo_lines[i]);
+    for (i = 0; i < UNDO_LINES && history.redo.start_line + i < num_lines; i++) {
+        strcpy(lines[history.redo.start_line + i], history.redo.lines[i]);
     }
     
-    num_lines = redo_num_lines;
-    cursor_x = redo_cursor_x;
-    cursor_y = redo_cursor_y;
-    scroll_offset = redo_scroll_offset;
+    num_lines = history.redo.num_lines;
+    cursor_x = history.redo.cursor_x;
+    cursor_y = history.redo.cursor_y;
+    scroll_offset = history.redo.scroll_offset;
     
     page_modified = 1;
+    hl_invalidate_all();
     update_cursor();
     show_message("REDONE", COL_GREEN);
 }
 
 int can_undo(void) {
-    return undo_available;
+    return history.undo.available;
 }
 
 int can_redo(void) {
-    return redo_available;
-}
\ No newline at end of file
+    return history.redo.available;
+}
+void *undo_history(uint16_t *size) {
+    *size = sizeof(history);
+    return &history;
+}
+
+void undo_clear(void) {
+    history.undo.available = 0;
+    history.redo.available = 0;
+}
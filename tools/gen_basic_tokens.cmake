@@ -0,0 +1,158 @@
+# Generate the BASIC V2 keyword tables from tools/basic_v2_tokens.txt
+#
+#   cmake -DINPUT=tools/basic_v2_tokens.txt -DOUTPUT_DIR=generated -P gen_basic_tokens.cmake
+#
+# Writes basic_tokens.h (a TOK_ constant per keyword) and basic_tokens.c,
+# a trie over the keywords: a lookup walks one node per character, so it
+# costs the length of the word no matter how many keywords there are,
+# and no two keywords can collide. Node 0 means "none". The first
+# character indexes basic_trie_root directly; below that each node links
+# to its first child and its next sibling.
+
+file(STRINGS "${INPUT}" rows)
+
+set(code 128)
+set(count 1)
+set(defines "")
+
+foreach(row IN LISTS rows)
+    if(row STREQUAL "" OR row MATCHES "^# ")
+        continue()
+    endif()
+    if(NOT row MATCHES "^([^ ]+) +([A-Z_]+)$")
+        message(FATAL_ERROR "bad line in ${INPUT}: ${row}")
+    endif()
+    set(word "${CMAKE_MATCH_1}")
+    set(name "${CMAKE_MATCH_2}")
+
+    math(EXPR v "${code}" OUTPUT_FORMAT HEXADECIMAL)
+    string(APPEND defines "#define TOK_${name} ${v}\n")
+
+    # Walk the word's prefixes, adding a node for each one not seen yet
+    string(LENGTH "${word}" n)
+    set(parent 0)
+    foreach(i RANGE 1 ${n})
+        string(SUBSTRING "${word}" 0 ${i} prefix)
+        string(HEX "${prefix}" key)
+        if(NOT DEFINED node_${key})
+            math(EXPR at "${i} - 1")
+            string(SUBSTRING "${word}" ${at} 1 ch)
+            string(HEX "${ch}" ch)
+            set(node_${key} ${count})
+            set(char_${count} 0x${ch})
+            set(next_${count} 0)
+            set(child_${count} 0)
+            set(token_${count} 0)
+
+            if(parent EQUAL 0)
+                math(EXPR slot "0x${ch} - 0x20")
+                if(slot LESS 0 OR slot GREATER 63)
+                    message(FATAL_ERROR "keyword ${word} starts outside $20-$5F")
+                endif()
+                set(root_${slot} ${count})
+            elseif(DEFINED last_child_${parent})
+                set(next_${last_child_${parent}} ${count})
+            else()
+                set(child_${parent} ${count})
+            endif()
+            set(last_child_${parent} ${count})
+            math(EXPR count "${count} + 1")
+        endif()
+        set(parent ${node_${key}})
+    endforeach()
+
+    if(NOT token_${parent} EQUAL 0)
+        message(FATAL_ERROR "keyword ${word} listed twice")
+    endif()
+    set(token_${parent} ${code})
+    math(EXPR code "${code} + 1")
+endforeach()
+
+if(count GREATER 256)
+    message(FATAL_ERROR "${count} trie nodes do not fit in a byte")
+endif()
+
+# Emit a list of numbers, 16 per line
+function(format_bytes out)
+    set(text "")
+    set(n 0)
+    foreach(v ${ARGN})
+        if(n EQUAL 0)
+            string(APPEND text "    ")
+        endif()
+        string(APPEND text "${v},")
+        math(EXPR n "(${n} + 1) % 16")
+        if(n EQUAL 0)
+            string(APPEND text "\n")
+        endif()
+    endforeach()
+    if(NOT n EQUAL 0)
+        string(APPEND text "\n")
+    endif()
+    set(${out} "${text}" PARENT_SCOPE)
+endfunction()
+
+set(root "")
+foreach(slot RANGE 0 63)
+    if(DEFINED root_${slot})
+        list(APPEND root ${root_${slot}})
+    else()
+        list(APPEND root 0)
+    endif()
+endforeach()
+format_bytes(root_text ${root})
+
+set(chars 0)
+set(nexts 0)
+set(childs 0)
+set(tokens 0)
+math(EXPR last "${count} - 1")
+foreach(i RANGE 1 ${last})
+    list(APPEND chars ${char_${i}})
+    list(APPEND nexts ${next_${i}})
+    list(APPEND childs ${child_${i}})
+    list(APPEND tokens ${token_${i}})
+endforeach()
+format_bytes(char_text ${chars})
+format_bytes(next_text ${nexts})
+format_bytes(child_text ${childs})
+format_bytes(token_text ${tokens})
+
+file(WRITE "${OUTPUT_DIR}/basic_tokens.h" "// Generated from basic_v2_tokens.txt by tools/gen_basic_tokens.cmake - do not edit
+
+#ifndef BASIC_TOKENS_H
+#define BASIC_TOKENS_H
+
+#include <stdint.h>
+
+${defines}
+// Keyword trie, see tools/gen_basic_tokens.cmake. Lookups are in basic.c.
+#define BASIC_TRIE_NODES ${count}
+extern const uint8_t basic_trie_root[64];      // first character - $20
+extern const uint8_t basic_trie_char[BASIC_TRIE_NODES];
+extern const uint8_t basic_trie_next[BASIC_TRIE_NODES];
+extern const uint8_t basic_trie_child[BASIC_TRIE_NODES];
+extern const uint8_t basic_trie_token[BASIC_TRIE_NODES];
+
+#endif // BASIC_TOKENS_H
+")
+
+file(WRITE "${OUTPUT_DIR}/basic_tokens.c" "// Generated from basic_v2_tokens.txt by tools/gen_basic_tokens.cmake - do not edit
+
+#include \"basic_tokens.h\"
+
+const uint8_t basic_trie_root[64] = {
+${root_text}};
+
+const uint8_t basic_trie_char[BASIC_TRIE_NODES] = {
+${char_text}};
+
+const uint8_t basic_trie_next[BASIC_TRIE_NODES] = {
+${next_text}};
+
+const uint8_t basic_trie_child[BASIC_TRIE_NODES] = {
+${child_text}};
+
+const uint8_t basic_trie_token[BASIC_TRIE_NODES] = {
+${token_text}};
+")
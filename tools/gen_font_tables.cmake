@@ -0,0 +1,124 @@
+# Generate the 80-column renderer's tables from include/font_4x8.h
+#
+#   cmake -DINPUT=include/font_4x8.h -DOUTPUT=font_tables.c -P gen_font_tables.cmake
+#
+# font_4x8.h keeps each 4-pixel glyph row in both nibbles. The renderer
+# wants them apart - left glyphs in the high nibble, right glyphs in the
+# low nibble - so a cell byte is a single OR with no masking or shifting.
+# Characters with bit 7 set are reversed by the renderer with an EOR.
+
+file(READ "${INPUT}" source)
+
+# The array runs from its opening brace to the first "};" - the comments
+# inside hold characters like '}' and '*', so take the hex bytes only
+string(FIND "${source}" "font_4x8[96 * 8] = {" start)
+if(start EQUAL -1)
+    message(FATAL_ERROR "font_4x8 array not found in ${INPUT}")
+endif()
+string(SUBSTRING "${source}" ${start} -1 source)
+string(FIND "${source}" "};" end)
+string(SUBSTRING "${source}" 0 ${end} source)
+string(REGEX MATCHALL "0x[0-9A-Fa-f][0-9A-Fa-f]" bytes "${source}")
+
+list(LENGTH bytes count)
+if(NOT count EQUAL 768)
+    message(FATAL_ERROR "expected 768 font bytes in ${INPUT}, found ${count}")
+endif()
+
+# Emit a list of numbers, 16 per line
+function(format_bytes out)
+    set(text "")
+    set(n 0)
+    foreach(v ${ARGN})
+        if(n EQUAL 0)
+            string(APPEND text "    ")
+        endif()
+        string(APPEND text "${v},")
+        math(EXPR n "(${n} + 1) % 16")
+        if(n EQUAL 0)
+            string(APPEND text "\n")
+        endif()
+    endforeach()
+    if(NOT n EQUAL 0)
+        string(APPEND text "\n")
+    endif()
+    set(${out} "${text}" PARENT_SCOPE)
+endfunction()
+
+set(left "")
+set(right "")
+foreach(b ${bytes})
+    math(EXPR l "${b} & 0xF0" OUTPUT_FORMAT HEXADECIMAL)
+    math(EXPR r "${b} & 0x0F" OUTPUT_FORMAT HEXADECIMAL)
+    list(APPEND left ${l})
+    list(APPEND right ${r})
+endforeach()
+format_bytes(font_text ${left} ${right})
+
+# Glyph offset per 7-bit character code; control codes show as a space
+set(lo "")
+set(page "")
+foreach(c RANGE 0 127)
+    if(c LESS 32)
+        set(g 0)
+    else()
+        math(EXPR g "${c} - 32")
+    endif()
+    math(EXPR off "${g} * 8")
+    math(EXPR v "${off} & 0xFF")
+    list(APPEND lo ${v})
+    math(EXPR v "${off} >> 8")
+    list(APPEND page ${v})
+endforeach()
+format_bytes(lo_text ${lo})
+format_bytes(page_text ${page})
+
+# Row start addresses: bitmap at $E000, 320 bytes a row; matrix at $D800
+set(bmp_lo "")
+set(bmp_hi "")
+set(mat_lo "")
+set(mat_hi "")
+foreach(y RANGE 0 24)
+    math(EXPR a "0xE000 + ${y} * 320")
+    math(EXPR v "${a} & 0xFF")
+    list(APPEND bmp_lo ${v})
+    math(EXPR v "${a} >> 8")
+    list(APPEND bmp_hi ${v})
+    math(EXPR a "0xD800 + ${y} * 40")
+    math(EXPR v "${a} & 0xFF")
+    list(APPEND mat_lo ${v})
+    math(EXPR v "${a} >> 8")
+    list(APPEND mat_hi ${v})
+endforeach()
+format_bytes(bmp_lo_text ${bmp_lo})
+format_bytes(bmp_hi_text ${bmp_hi})
+format_bytes(mat_lo_text ${mat_lo})
+format_bytes(mat_hi_text ${mat_hi})
+
+file(WRITE "${OUTPUT}" "// Generated from font_4x8.h by tools/gen_font_tables.cmake - do not edit
+
+#include \"font_tables.h\"
+
+// Page aligned so a glyph's 8 rows never cross a page
+__attribute__((aligned(256)))
+const uint8_t font_lr[FONT_LR_SIZE] = {
+${font_text}};
+
+const uint8_t glyph_lo[128] = {
+${lo_text}};
+
+const uint8_t glyph_page[128] = {
+${page_text}};
+
+const uint8_t bitmap_row_lo[25] = {
+${bmp_lo_text}};
+
+const uint8_t bitmap_row_hi[25] = {
+${bmp_hi_text}};
+
+const uint8_t matrix_row_lo[25] = {
+${mat_lo_text}};
+
+const uint8_t matrix_row_hi[25] = {
+${mat_hi_text}};
+")